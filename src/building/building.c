@@ -10,6 +10,7 @@
 #include "building/properties.h"
 #include "building/rotation.h"
 #include "building/storage.h"
+#include "building/warehouse.h"
 #include "city/buildings.h"
 #include "city/finance.h"
 #include "city/population.h"
@@ -29,12 +30,26 @@
 #include "map/terrain.h"
 #include "map/tiles.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 #define BUILDING_ARRAY_SIZE_STEP 2000
 
+typedef struct {
+    int *ids;
+    int size;
+    int capacity;
+    int cursor;
+} category_list;
+
 static struct {
     array(building) buildings;
     building *first_of_type[BUILDING_TYPE_MAX];
     building *last_of_type[BUILDING_TYPE_MAX];
+    struct {
+        int is_valid;
+        category_list lists[BUILDING_CATEGORY_MAX];
+    } categories;
 } data;
 
 static struct {
@@ -68,6 +83,173 @@ building *building_first_of_type(building_type type)
     return data.first_of_type[type];
 }
 
+static building_category category_for_type(building_type type)
+{
+    if (building_is_house(type)) {
+        return BUILDING_CATEGORY_HOUSES;
+    }
+    if (building_is_primary_product_producer(type) || building_is_workshop(type)) {
+        return BUILDING_CATEGORY_INDUSTRY;
+    }
+    switch (type) {
+        case BUILDING_GRANARY:
+        case BUILDING_WAREHOUSE:
+        case BUILDING_WAREHOUSE_SPACE:
+            return BUILDING_CATEGORY_STORAGE;
+        case BUILDING_THEATER:
+        case BUILDING_AMPHITHEATER:
+        case BUILDING_ARENA:
+        case BUILDING_COLOSSEUM:
+        case BUILDING_HIPPODROME:
+        case BUILDING_TAVERN:
+        case BUILDING_ACTOR_COLONY:
+        case BUILDING_GLADIATOR_SCHOOL:
+        case BUILDING_LION_HOUSE:
+        case BUILDING_CHARIOT_MAKER:
+        case BUILDING_SCHOOL:
+        case BUILDING_ACADEMY:
+        case BUILDING_LIBRARY:
+        case BUILDING_ORACLE:
+        case BUILDING_LARARIUM:
+        case BUILDING_NYMPHAEUM:
+        case BUILDING_PANTHEON:
+            return BUILDING_CATEGORY_CULTURE;
+        case BUILDING_FORT:
+        case BUILDING_FORT_GROUND:
+        case BUILDING_FORT_LEGIONARIES:
+        case BUILDING_FORT_JAVELIN:
+        case BUILDING_FORT_MOUNTED:
+        case BUILDING_BARRACKS:
+        case BUILDING_MILITARY_ACADEMY:
+        case BUILDING_MESS_HALL:
+        case BUILDING_TOWER:
+        case BUILDING_GATEHOUSE:
+        case BUILDING_WATCHTOWER:
+            return BUILDING_CATEGORY_MILITARY;
+        default:
+            break;
+    }
+    if ((type >= BUILDING_SMALL_TEMPLE_CERES && type <= BUILDING_LARGE_TEMPLE_VENUS) ||
+        (type >= BUILDING_GRAND_TEMPLE_CERES && type <= BUILDING_GRAND_TEMPLE_VENUS)) {
+        return BUILDING_CATEGORY_CULTURE;
+    }
+    return BUILDING_CATEGORY_ALL;
+}
+
+static int is_in_category(const building *b, building_category category)
+{
+    return b->state != BUILDING_STATE_UNUSED &&
+        (category == BUILDING_CATEGORY_ALL || category_for_type(b->type) == category);
+}
+
+// Index of the first id in the list that is higher than the given id
+static int category_list_position(const category_list *list, int id)
+{
+    int low = 0;
+    int high = list->size;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (list->ids[middle] <= id) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+static int category_list_add(category_list *list, int id)
+{
+    int position = category_list_position(list, id);
+    if (position > 0 && list->ids[position - 1] == id) {
+        return 1;
+    }
+    if (list->size >= list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : BUILDING_ARRAY_SIZE_STEP;
+        int *ids = realloc(list->ids, sizeof(int) * capacity);
+        if (!ids) {
+            return 0;
+        }
+        list->ids = ids;
+        list->capacity = capacity;
+    }
+    memmove(&list->ids[position + 1], &list->ids[position], sizeof(int) * (list->size - position));
+    list->ids[position] = id;
+    list->size++;
+    return 1;
+}
+
+static void category_list_remove(category_list *list, int id)
+{
+    int position = category_list_position(list, id) - 1;
+    if (position < 0 || list->ids[position] != id) {
+        return;
+    }
+    list->size--;
+    memmove(&list->ids[position], &list->ids[position + 1], sizeof(int) * (list->size - position));
+}
+
+static void add_to_categories(const building *b)
+{
+    if (!b->id || !data.categories.is_valid) {
+        return;
+    }
+    building_category category = category_for_type(b->type);
+    if (!category_list_add(&data.categories.lists[BUILDING_CATEGORY_ALL], b->id) ||
+        (category != BUILDING_CATEGORY_ALL && !category_list_add(&data.categories.lists[category], b->id))) {
+        data.categories.is_valid = 0;
+    }
+}
+
+static void remove_from_categories(const building *b)
+{
+    if (!b->id || !data.categories.is_valid) {
+        return;
+    }
+    building_category category = category_for_type(b->type);
+    category_list_remove(&data.categories.lists[BUILDING_CATEGORY_ALL], b->id);
+    if (category != BUILDING_CATEGORY_ALL) {
+        category_list_remove(&data.categories.lists[category], b->id);
+    }
+}
+
+static void clear_categories(void)
+{
+    for (int i = 0; i < BUILDING_CATEGORY_MAX; i++) {
+        data.categories.lists[i].size = 0;
+    }
+    data.categories.is_valid = 1;
+}
+
+building *building_first_in_category(building_category category)
+{
+    return building_next_in_category(category, array_first(data.buildings));
+}
+
+building *building_next_in_category(building_category category, const building *b)
+{
+    if (!data.categories.is_valid) {
+        for (int id = b->id + 1; id < data.buildings.size; id++) {
+            building *next = array_item(data.buildings, id);
+            if (is_in_category(next, category)) {
+                return next;
+            }
+        }
+        return 0;
+    }
+    category_list *list = &data.categories.lists[category];
+    int position = list->cursor;
+    // Fast path for the usual loop, where b is the building returned last time or it has just been removed
+    if (position >= list->size || list->ids[position] < b->id ||
+        (position > 0 && list->ids[position - 1] > b->id)) {
+        position = category_list_position(list, b->id);
+    } else if (list->ids[position] == b->id) {
+        position++;
+    }
+    list->cursor = position;
+    return position < list->size ? array_item(data.buildings, list->ids[position]) : 0;
+}
+
 building *building_main(building *b)
 {
     for (int guard = 0; guard < 9; guard++) {
@@ -86,6 +268,12 @@ building *building_next(building *b)
 
 static void fill_adjacent_types(building *b)
 {
+    if (b->type == BUILDING_WAREHOUSE || b->type == BUILDING_WAREHOUSE_SPACE) {
+        building_warehouse_invalidate_inventory();
+    } else if (b->type == BUILDING_GRANARY) {
+        building_granary_invalidate_food_index();
+    }
+    add_to_categories(b);
     building *first = data.first_of_type[b->type];
     building *last = data.last_of_type[b->type];
     if (!first || !last) {
@@ -122,6 +310,12 @@ static void fill_adjacent_types(building *b)
 
 static void remove_adjacent_types(building *b)
 {
+    if (b->type == BUILDING_WAREHOUSE || b->type == BUILDING_WAREHOUSE_SPACE) {
+        building_warehouse_invalidate_inventory();
+    } else if (b->type == BUILDING_GRANARY) {
+        building_granary_invalidate_food_index();
+    }
+    remove_from_categories(b);
     building *first = data.first_of_type[b->type];
     building *last = data.last_of_type[b->type];
     if (b == first && b == last) {
@@ -370,9 +564,8 @@ void building_update_state(void)
     int wall_recalc = 0;
     int road_recalc = 0;
     int aqueduct_recalc = 0;
-    building *b;
-    array_foreach(data.buildings, b)
-    {
+    for (building *b = building_first_in_category(BUILDING_CATEGORY_ALL); b;
+         b = building_next_in_category(BUILDING_CATEGORY_ALL, b)) {
         if (b->state == BUILDING_STATE_CREATED) {
             b->state = BUILDING_STATE_IN_USE;
         }
@@ -390,7 +583,7 @@ void building_update_state(void)
             } else if ((b->type >= BUILDING_GRAND_TEMPLE_CERES && b->type <= BUILDING_GRAND_TEMPLE_VENUS) || b->type == BUILDING_PANTHEON || b->type == BUILDING_LIGHTHOUSE) {
                 road_recalc = 1;
             }
-            map_building_tiles_remove(i, b->x, b->y);
+            map_building_tiles_remove(b->id, b->x, b->y);
             if (building_type_is_roadblock(b->type)) {
                 // Leave the road behind the deleted roadblock
                 map_terrain_add(b->grid_offset, TERRAIN_ROAD);
@@ -423,9 +616,8 @@ void building_update_state(void)
 
 void building_update_desirability(void)
 {
-    building *b;
-    array_foreach(data.buildings, b)
-    {
+    for (building *b = building_first_in_category(BUILDING_CATEGORY_ALL); b;
+         b = building_next_in_category(BUILDING_CATEGORY_ALL, b)) {
         if (b->state != BUILDING_STATE_IN_USE) {
             continue;
         }
@@ -621,6 +813,9 @@ void building_clear_all(void)
 {
     memset(data.first_of_type, 0, sizeof(data.first_of_type));
     memset(data.last_of_type, 0, sizeof(data.last_of_type));
+    clear_categories();
+    building_warehouse_invalidate_inventory();
+    building_granary_invalidate_food_index();
 
     if (!array_init(data.buildings, BUILDING_ARRAY_SIZE_STEP, initialize_new_building, building_in_use) ||
         !array_next(data.buildings)) { // Ignore first building
@@ -672,6 +867,9 @@ void building_load_state(buffer *buf, buffer *sequence, buffer *corrupt_houses,
 
     memset(data.first_of_type, 0, sizeof(data.first_of_type));
     memset(data.last_of_type, 0, sizeof(data.last_of_type));
+    clear_categories();
+    building_warehouse_invalidate_inventory();
+    building_granary_invalidate_food_index();
 
     int highest_id_in_use = 0;
 
@@ -44,16 +44,16 @@ typedef struct building {
     short house_unreachable_ticks;
     unsigned char road_access_x;
     unsigned char road_access_y;
-    short figure_id;
-    short figure_id2; // labor seeker or market supplier
-    short immigrant_figure_id;
-    short figure_id4; // tower ballista, burning ruin prefect, doctor healing plague
+    int figure_id;
+    int figure_id2; // labor seeker or market supplier
+    int immigrant_figure_id;
+    int figure_id4; // tower ballista, burning ruin prefect, doctor healing plague
     unsigned char figure_spawn_delay;
     unsigned char days_since_offering;
     unsigned char figure_roam_direction;
     unsigned char has_water_access;
-    short prev_part_building_id;
-    short next_part_building_id;
+    int prev_part_building_id;
+    int next_part_building_id;
     short loads_stored;
     unsigned char house_sentiment_message;
     unsigned char has_well_access;
@@ -73,11 +73,11 @@ typedef struct building {
     signed char monthly_levy;
     union {
         struct {
-            short queued_docker_id;
+            int queued_docker_id;
             unsigned char num_ships;
             signed char orientation;
-            short docker_ids[3];
-            short trade_ship_id;
+            int docker_ids[3];
+            int trade_ship_id;
             unsigned char has_accepted_route_ids;
             int accepted_route_ids;
         } dock;
@@ -101,7 +101,7 @@ typedef struct building {
             unsigned char has_fish;
             unsigned char is_stockpiling;
             unsigned char orientation;
-            short fishing_boat_id;
+            int fishing_boat_id;
             unsigned char age_months;
             unsigned char average_production_per_month;
             short production_current_month;
@@ -188,6 +188,16 @@ typedef struct building {
     unsigned char fumigation_direction;
 } building;
 
+typedef enum {
+    BUILDING_CATEGORY_ALL = 0,
+    BUILDING_CATEGORY_HOUSES = 1,
+    BUILDING_CATEGORY_INDUSTRY = 2,
+    BUILDING_CATEGORY_STORAGE = 3,
+    BUILDING_CATEGORY_CULTURE = 4,
+    BUILDING_CATEGORY_MILITARY = 5,
+    BUILDING_CATEGORY_MAX = 6
+} building_category;
+
 building *building_get(int id);
 
 int building_count(void);
@@ -196,6 +206,10 @@ int building_find(building_type type);
 
 building *building_first_of_type(building_type type);
 
+building *building_first_in_category(building_category category);
+
+building *building_next_in_category(building_category category, const building *b);
+
 void building_change_type(building *b, building_type type);
 
 building *building_main(building *b);
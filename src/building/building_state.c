@@ -160,6 +160,32 @@ static void write_type_data(buffer *buf, const building *b)
     }
 }
 
+static void write_expanded_ids(buffer *buf, const building *b)
+{
+    buffer_write_i32(buf, b->figure_id);
+    buffer_write_i32(buf, b->figure_id2);
+    buffer_write_i32(buf, b->immigrant_figure_id);
+    buffer_write_i32(buf, b->figure_id4);
+    buffer_write_i32(buf, b->prev_part_building_id);
+    buffer_write_i32(buf, b->next_part_building_id);
+    if (b->type == BUILDING_DOCK) {
+        buffer_write_i32(buf, b->data.dock.queued_docker_id);
+        for (int i = 0; i < 3; i++) {
+            buffer_write_i32(buf, b->data.dock.docker_ids[i]);
+        }
+        buffer_write_i32(buf, b->data.dock.trade_ship_id);
+    } else if (b->type == BUILDING_WHARF) {
+        buffer_write_i32(buf, b->data.industry.fishing_boat_id);
+        for (int i = 0; i < 4; i++) {
+            buffer_write_i32(buf, 0);
+        }
+    } else {
+        for (int i = 0; i < 5; i++) {
+            buffer_write_i32(buf, 0);
+        }
+    }
+}
+
 void building_state_save_to_buffer(buffer *buf, const building *b)
 {
     buffer_write_u8(buf, b->state);
@@ -247,6 +273,9 @@ void building_state_save_to_buffer(buffer *buf, const building *b)
     buffer_write_u8(buf, b->fumigation_frame);
     buffer_write_u8(buf, b->fumigation_direction);
 
+    // expanded ids
+    write_expanded_ids(buf, b);
+
     // New building state code should always be added at the end to preserve savegame retrocompatibility
     // Also, don't forget to update BUILDING_STATE_CURRENT_BUFFER_SIZE and if possible, add a new macro like
     // BUILDING_STATE_NEW_FEATURE_BUFFER_SIZE with the full building state buffer size including all added features
@@ -381,6 +410,28 @@ static void read_type_data(buffer *buf, building *b, int building_buf_size)
     }
 }
 
+static void read_expanded_ids(buffer *buf, building *b)
+{
+    b->figure_id = buffer_read_i32(buf);
+    b->figure_id2 = buffer_read_i32(buf);
+    b->immigrant_figure_id = buffer_read_i32(buf);
+    b->figure_id4 = buffer_read_i32(buf);
+    b->prev_part_building_id = buffer_read_i32(buf);
+    b->next_part_building_id = buffer_read_i32(buf);
+    if (b->type == BUILDING_DOCK) {
+        b->data.dock.queued_docker_id = buffer_read_i32(buf);
+        for (int i = 0; i < 3; i++) {
+            b->data.dock.docker_ids[i] = buffer_read_i32(buf);
+        }
+        b->data.dock.trade_ship_id = buffer_read_i32(buf);
+    } else if (b->type == BUILDING_WHARF) {
+        b->data.industry.fishing_boat_id = buffer_read_i32(buf);
+        buffer_skip(buf, 16);
+    } else {
+        buffer_skip(buf, 20);
+    }
+}
+
 void building_state_load_from_buffer(buffer *buf, building *b, int building_buf_size, int save_version)
 {
     b->state = buffer_read_u8(buf);
@@ -519,6 +570,10 @@ void building_state_load_from_buffer(buffer *buf, building *b, int building_buf_
         b->fumigation_direction = buffer_read_u8(buf);
     }
 
+    if (building_buf_size >= BUILDING_STATE_EXPANDED_IDS) {
+        read_expanded_ids(buf, b);
+    }
+
     // The following code should only be executed if the savegame includes building information that is not 
     // supported on this specific version of Augustus. The extra bytes in the buffer must be skipped in order
     // to prevent reading bogus data for the next building
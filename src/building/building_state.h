@@ -9,7 +9,8 @@
 #define BUILDING_STATE_VARIANTS_AND_UPGRADES 136
 #define BUILDING_STATE_STRIKES 137
 #define BUILDING_STATE_SICKNESS 142
-#define BUILDING_STATE_CURRENT_BUFFER_SIZE 142
+#define BUILDING_STATE_EXPANDED_IDS 186
+#define BUILDING_STATE_CURRENT_BUFFER_SIZE 186
 
 
 void building_state_save_to_buffer(buffer *buf, const building *b);
@@ -86,8 +86,8 @@ void building_count_update(void)
     city_buildings_reset_dock_wharf_counters();
     city_health_reset_hospital_workers();
 
-    for (int i = 1; i < building_count(); i++) {
-        building *b = building_get(i);
+    for (building *b = building_first_in_category(BUILDING_CATEGORY_ALL); b;
+         b = building_next_in_category(BUILDING_CATEGORY_ALL, b)) {
         if (b->state != BUILDING_STATE_IN_USE || b->house_size) {
             continue;
         }
@@ -106,7 +106,7 @@ void building_count_update(void)
                 break;
 
             case BUILDING_BARRACKS:
-                city_buildings_set_barracks(i);
+                city_buildings_set_barracks(b->id);
                 increase_count(type, b->num_workers > 0, b->upgrade_level);
                 break;
 
@@ -228,7 +228,7 @@ void building_count_update(void)
                 break;
             case BUILDING_DOCK:
                 if (b->num_workers > 0 && b->has_water_access) {
-                    city_buildings_add_working_dock(i);
+                    city_buildings_add_working_dock(b->id);
                 }
                 break;
             default:
@@ -236,7 +236,7 @@ void building_count_update(void)
         }
         if (b->immigrant_figure_id) {
             figure *f = figure_get(b->immigrant_figure_id);
-            if (f->state != FIGURE_STATE_ALIVE || f->destination_building_id != i) {
+            if (f->state != FIGURE_STATE_ALIVE || f->destination_building_id != b->id) {
                 b->immigrant_figure_id = 0;
             }
         }
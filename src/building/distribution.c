@@ -1,5 +1,6 @@
 #include "distribution.h"
 
+#include "building/granary.h"
 #include "building/storage.h"
 #include "building/warehouse.h"
 #include "city/resource.h"
@@ -91,6 +92,19 @@ static int is_invalid_destination(building *b, int permission, int road_network)
         !building_storage_get_permission(permission, b));
 }
 
+static void find_food_storage(inventory_storage_info *info, resource_type resource, building_type type,
+    int permission, int road_network, int x, int y)
+{
+    for (building *b = building_granary_next_for_food(GRANARIES_HOLDING, resource, 0); b;
+        b = building_granary_next_for_food(GRANARIES_HOLDING, resource, b)) {
+        // Looter walkers have no type
+        if (type && is_invalid_destination(b, permission, road_network)) {
+            continue;
+        }
+        update_food_resource(info, resource, b, calc_maximum_distance(x, y, b->x, b->y));
+    }
+}
+
 int building_distribution_get_inventory_storages(inventory_storage_info *info, building_type type,
     int road_network, int x, int y, int max_distance)
 {
@@ -107,18 +121,10 @@ int building_distribution_get_inventory_storages(inventory_storage_info *info, b
         permission = BUILDING_STORAGE_PERMISSION_MARKET;
     }
 
-    for (building *b = building_first_of_type(BUILDING_GRANARY); b; b = b->next_of_type) {
-        // Looter walkers have no type
-        if (type && is_invalid_destination(b, permission, road_network)) {
-            continue;
-        }
-        int distance = calc_maximum_distance(x, y, b->x, b->y);
-
-        update_food_resource(&info[INVENTORY_WHEAT], RESOURCE_WHEAT, b, distance);
-        update_food_resource(&info[INVENTORY_VEGETABLES], RESOURCE_VEGETABLES, b, distance);
-        update_food_resource(&info[INVENTORY_FRUIT], RESOURCE_FRUIT, b, distance);
-        update_food_resource(&info[INVENTORY_MEAT], RESOURCE_MEAT, b, distance);
-    }
+    find_food_storage(&info[INVENTORY_WHEAT], RESOURCE_WHEAT, type, permission, road_network, x, y);
+    find_food_storage(&info[INVENTORY_VEGETABLES], RESOURCE_VEGETABLES, type, permission, road_network, x, y);
+    find_food_storage(&info[INVENTORY_FRUIT], RESOURCE_FRUIT, type, permission, road_network, x, y);
+    find_food_storage(&info[INVENTORY_MEAT], RESOURCE_MEAT, type, permission, road_network, x, y);
     for (building *b = building_first_of_type(BUILDING_WAREHOUSE); b; b = b->next_of_type) {
         if (type && is_invalid_destination(b, permission, road_network)) {
             continue;
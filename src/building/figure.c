@@ -1705,8 +1705,8 @@ void building_figure_generate(void)
 {
     int patrician_generated = 0;
     building_barracks_decay_tower_sentry_request();
-    for (int i = 1; i < building_count(); i++) {
-        building *b = building_get(i);
+    for (building *b = building_first_in_category(BUILDING_CATEGORY_ALL); b;
+         b = building_next_in_category(BUILDING_CATEGORY_ALL, b)) {
         if (b->state != BUILDING_STATE_IN_USE) {
             b->show_on_problem_overlay = 1;
             continue;
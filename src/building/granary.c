@@ -10,6 +10,7 @@
 #include "city/resource.h"
 #include "core/calc.h"
 #include "core/config.h"
+#include "core/log.h"
 #include "empire/trade_prices.h"
 #include "figure/figure.h"
 #include "map/road_access.h"
@@ -17,10 +18,15 @@
 #include "scenario/property.h"
 #include "sound/effect.h"
 
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
 #define MAX_GRANARIES 100
 #define UNITS_PER_LOAD 100
 #define CURSE_LOADS 16
 #define INFINITE 10000
+#define ALL_GRANARIES -1
 
 static struct {
     int building_ids[MAX_GRANARIES];
@@ -31,6 +37,13 @@ static struct {
     int total_storage_meat;
 } non_getting_granaries;
 
+static struct {
+    int is_valid;
+    uint32_t *lists; // one bit per building id for every list and food
+    int list_words;
+    int list_capacity;
+} food_index;
+
 static int get_amount(building *granary, int resource)
 {
     if (!resource_is_food(resource)) {
@@ -87,6 +100,117 @@ int building_granary_is_not_accepting(int resource, building *b)
     return !((building_granary_is_accepting(resource, b) || building_granary_is_getting(resource, b)));
 }
 
+static uint32_t *get_list(int list, int resource)
+{
+    return &food_index.lists[(list * RESOURCE_MAX_FOOD + resource) * food_index.list_words];
+}
+
+static void set_listed(int list, int resource, int building_id, int listed)
+{
+    uint32_t *words = get_list(list, resource);
+    if (listed) {
+        words[building_id >> 5] |= 1u << (building_id & 31);
+    } else {
+        words[building_id >> 5] &= ~(1u << (building_id & 31));
+    }
+}
+
+static int is_listed(int list, int resource, building *granary)
+{
+    int room = granary->data.granary.resource_stored[RESOURCE_NONE];
+    switch (list) {
+        case GRANARIES_HOLDING:
+            return granary->data.granary.resource_stored[resource] > 0;
+        case GRANARIES_ACCEPTING:
+            return !building_storage_get(granary->storage_id)->empty_all && room >= RESOURCE_GRANARY_ONE_LOAD &&
+                !building_granary_is_not_accepting(resource, granary);
+        case GRANARIES_GETTING:
+            return !building_storage_get(granary->storage_id)->empty_all && room > RESOURCE_GRANARY_ONE_LOAD &&
+                building_granary_is_getting(resource, granary);
+        default:
+            return 1;
+    }
+}
+
+static void update_food_index(building *granary)
+{
+    if (!food_index.is_valid || granary->type != BUILDING_GRANARY) {
+        return;
+    }
+    for (int list = 0; list < GRANARY_FOOD_LISTS; list++) {
+        for (int r = 0; r < RESOURCE_MAX_FOOD; r++) {
+            set_listed(list, r, granary->id, is_listed(list, r, granary));
+        }
+    }
+}
+
+static int allocate_lists(void)
+{
+    int words = (building_count() >> 5) + 1;
+    int capacity = words * GRANARY_FOOD_LISTS * RESOURCE_MAX_FOOD;
+    if (capacity > food_index.list_capacity) {
+        uint32_t *lists = realloc(food_index.lists, capacity * sizeof(uint32_t));
+        if (!lists) {
+            return 0;
+        }
+        food_index.lists = lists;
+        food_index.list_capacity = capacity;
+    }
+    food_index.list_words = words;
+    memset(food_index.lists, 0, capacity * sizeof(uint32_t));
+    return 1;
+}
+
+static int ensure_food_index(void)
+{
+    if (food_index.is_valid) {
+        return 1;
+    }
+    if (!allocate_lists()) {
+        log_error("Unable to allocate memory for the granary food index", 0, 0);
+        return 0;
+    }
+    food_index.is_valid = 1;
+    for (building *b = building_first_of_type(BUILDING_GRANARY); b; b = b->next_of_type) {
+        update_food_index(b);
+    }
+    return 1;
+}
+
+void building_granary_invalidate_food_index(void)
+{
+    food_index.is_valid = 0;
+}
+
+static building *next_granary(int list, int resource, building *b)
+{
+    if (list == ALL_GRANARIES || !ensure_food_index()) {
+        b = b ? b->next_of_type : building_first_of_type(BUILDING_GRANARY);
+        while (b && !is_listed(list, resource, b)) {
+            b = b->next_of_type;
+        }
+        return b;
+    }
+    const uint32_t *words = get_list(list, resource);
+    int id = b ? b->id + 1 : 0;
+    for (int word = id >> 5; word < food_index.list_words; word++, id = word << 5) {
+        uint32_t bits = words[word] >> (id & 31);
+        while (bits) {
+            if (bits & 1) {
+                return building_get(id);
+            }
+            bits >>= 1;
+            id++;
+        }
+    }
+    return 0;
+}
+
+building *building_granary_next_for_food(granary_food_list list, int resource, building *b)
+{
+    return next_granary(list, resource, b);
+}
+
 int building_granary_is_full(int resource, building *b)
 {
     return b->data.granary.resource_stored[RESOURCE_NONE] <= 0;
@@ -148,6 +272,7 @@ int building_granary_add_resource(building *granary, int resource, int is_produc
         granary->data.granary.resource_stored[resource] += RESOURCE_GRANARY_ONE_LOAD;
         granary->data.granary.resource_stored[RESOURCE_NONE] -= RESOURCE_GRANARY_ONE_LOAD;
     }
+    update_food_index(granary);
     return 1;
 }
 
@@ -169,6 +294,7 @@ int building_granary_remove_resource(building *granary, int resource, int amount
     city_resource_remove_from_granary(resource, removed);
     granary->data.granary.resource_stored[resource] -= removed;
     granary->data.granary.resource_stored[RESOURCE_NONE] += removed;
+    update_food_index(granary);
     return amount - removed;
 }
 
@@ -400,7 +526,9 @@ int building_granary_for_storing(int x, int y, int resource, int road_network_id
     }
     int min_dist = INFINITE;
     int min_building_id = 0;
-    for (building *b = building_first_of_type(BUILDING_GRANARY); b; b = b->next_of_type) {
+    // the understaffed count includes granaries that do not accept the food, so all of them have to be checked then
+    int list = understaffed ? ALL_GRANARIES : GRANARIES_ACCEPTING;
+    for (building *b = next_granary(list, resource, 0); b; b = next_granary(list, resource, b)) {
         if (b->road_network_id != road_network_id ||
             !building_granary_accepts_storage(b, resource, understaffed)) {
             continue;
@@ -431,7 +559,7 @@ int building_getting_granary_for_storing(int x, int y, int resource, int road_ne
     }
     int min_dist = INFINITE;
     int min_building_id = 0;
-    for (building *b = building_first_of_type(BUILDING_GRANARY); b; b = b->next_of_type) {
+    for (building *b = next_granary(GRANARIES_GETTING, resource, 0); b; b = next_granary(GRANARIES_GETTING, resource, b)) {
         if (b->state != BUILDING_STATE_IN_USE || b->has_plague) {
             continue;
         }
@@ -615,6 +743,7 @@ void building_granary_update_built_granaries_capacity()
 
         if (total_units < 3200) {
             b->data.granary.resource_stored[RESOURCE_NONE] += 3200 - total_units;
+            update_food_index(b);
         }
         // for now, we don't handle the case where we decrease granary capacity
     }
@@ -15,6 +15,13 @@ enum {
     GRANARY_TASK_GETTING = 0
 };
 
+typedef enum {
+    GRANARIES_HOLDING = 0, // granaries that have some of the food
+    GRANARIES_ACCEPTING = 1, // granaries that accept the food and have room for a load
+    GRANARIES_GETTING = 2, // granaries that get the food and have room for more than a load
+    GRANARY_FOOD_LISTS = 3
+} granary_food_list;
+
 int building_granary_add_import(building *granary, int resource, int land_trader);
 
 int building_granary_remove_export(building *granary, int resource, int land_trader);
@@ -58,4 +65,8 @@ int building_granary_is_getting(int resource, building* b);
 
 void building_granary_update_built_granaries_capacity();
 
+building *building_granary_next_for_food(granary_food_list list, int resource, building *b);
+
+void building_granary_invalidate_food_index(void);
+
 #endif // BUILDING_GRANARY_H
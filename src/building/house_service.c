@@ -63,8 +63,8 @@ void house_service_decay_tax_collector(void)
 
 void house_service_decay_houses_covered(void)
 {
-    for (int i = 1; i < building_count(); i++) {
-        building *b = building_get(i);
+    for (building *b = building_first_in_category(BUILDING_CATEGORY_ALL); b;
+         b = building_next_in_category(BUILDING_CATEGORY_ALL, b)) {
         if (b->state != BUILDING_STATE_UNUSED && b->type != BUILDING_TOWER) {
             if (b->houses_covered <= 1) {
                 b->houses_covered = 0;
@@ -40,8 +40,8 @@ void building_maintenance_update_burning_ruins(void)
     scenario_climate climate = scenario_property_climate();
     int recalculate_terrain = 0;
     building_list_burning_clear();
-    for (int i = 1; i < building_count(); i++) {
-        building *b = building_get(i);
+    for (building *b = building_first_in_category(BUILDING_CATEGORY_ALL); b;
+         b = building_next_in_category(BUILDING_CATEGORY_ALL, b)) {
         if ((b->state != BUILDING_STATE_IN_USE && b->state != BUILDING_STATE_MOTHBALLED) || b->type != BUILDING_BURNING_RUIN) {
             continue;
         }
@@ -52,14 +52,14 @@ void building_maintenance_update_burning_ruins(void)
         if (b->fire_duration > 32) {
             game_undo_disable();
             b->state = BUILDING_STATE_RUBBLE;
-            map_building_tiles_set_rubble(i, b->x, b->y, b->size);
+            map_building_tiles_set_rubble(b->id, b->x, b->y, b->size);
             recalculate_terrain = 1;
             continue;
         }
         if (b->has_plague) {
             continue;
         }
-        building_list_burning_add(i);
+        building_list_burning_add(b->id);
         if (climate == CLIMATE_DESERT) {
             if (b->fire_duration & 3) { // check spread every 4 ticks
                 continue;
@@ -168,15 +168,15 @@ void building_maintenance_check_fire_collapse(void)
     int recalculate_terrain = 0;
     int random_global = random_byte() & 7;
 
-    for (int i = 1; i < building_count(); i++) {
-        building *b = building_get(i);
+    for (building *b = building_first_in_category(BUILDING_CATEGORY_ALL); b;
+         b = building_next_in_category(BUILDING_CATEGORY_ALL, b)) {
         if (b->state != BUILDING_STATE_IN_USE || b->fire_proof) {
             continue;
         }
         if (b->type == BUILDING_HIPPODROME && b->prev_part_building_id) {
             continue;
         }
-        int random_building = (i + map_random_get(b->grid_offset)) & 7;
+        int random_building = (b->id + map_random_get(b->grid_offset)) & 7;
         // damage
         b->damage_risk += random_building == random_global ? 3 : 1;
         if (tutorial_extra_damage_risk()) {
@@ -231,8 +231,8 @@ void building_maintenance_check_rome_access(void)
     const map_tile *entry_point = city_map_entry_point();
     map_routing_calculate_distances(entry_point->x, entry_point->y);
     int problem_grid_offset = 0;
-    for (int i = 1; i < building_count(); i++) {
-        building *b = building_get(i);
+    for (building *b = building_first_in_category(BUILDING_CATEGORY_ALL); b;
+         b = building_next_in_category(BUILDING_CATEGORY_ALL, b)) {
         if (b->state != BUILDING_STATE_IN_USE) {
             continue;
         }
@@ -1,6 +1,7 @@
 #include "storage.h"
 
 #include "building/building.h"
+#include "building/granary.h"
 #include "city/resource.h"
 #include "core/array.h"
 #include "core/calc.h"
@@ -36,6 +37,7 @@ void building_storage_clear_all(void)
         !array_next(storages)) { // Ignore first storage
         log_error("Unable to create storages. The game will likely crash.", 0, 0);
     }
+    building_granary_invalidate_food_index();
 }
 
 void building_storage_reset_building_ids(void)
@@ -103,12 +105,14 @@ const building_storage *building_storage_get(int storage_id)
 void building_storage_set_data(int storage_id, building_storage new_data)
 {
     array_item(storages, storage_id)->storage = new_data;
+    building_granary_invalidate_food_index();
 }
 
 
 void building_storage_toggle_empty_all(int storage_id)
 {
     array_item(storages, storage_id)->storage.empty_all ^= 1;
+    building_granary_invalidate_food_index();
 }
 
 void building_storage_cycle_resource_state(int storage_id, resource_type resource_id)
@@ -140,6 +144,7 @@ void building_storage_cycle_resource_state(int storage_id, resource_type resourc
         state = BUILDING_STORAGE_STATE_GETTING_3QUARTERS;
     }
     array_item(storages, storage_id)->storage.resource_state[resource_id] = state;
+    building_granary_invalidate_food_index();
 }
 
 void building_storage_set_permission(building_storage_permission_states p, building *b)
@@ -177,6 +182,7 @@ void building_storage_cycle_partial_resource_state(int storage_id, resource_type
         state = BUILDING_STORAGE_STATE_GETTING;
     }
     array_item(storages, storage_id)->storage.resource_state[resource_id] = state;
+    building_granary_invalidate_food_index();
 }
 void building_storage_accept_none(int storage_id)
 {
@@ -184,6 +190,7 @@ void building_storage_accept_none(int storage_id)
     for (int r = RESOURCE_MIN; r < RESOURCE_MAX; r++) {
         s->storage.resource_state[r] = BUILDING_STORAGE_STATE_NOT_ACCEPTING;
     }
+    building_granary_invalidate_food_index();
 }
 
 void building_storage_save_state(buffer *buf)
@@ -245,4 +252,5 @@ void building_storage_load_state(buffer *buf, int includes_storage_size)
     }
 
     storages.size = highest_id_in_use + 1;
+    building_granary_invalidate_food_index();
 }
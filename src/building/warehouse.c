@@ -9,35 +9,188 @@
 #include "building/storage.h"
 #include "city/finance.h"
 #include "city/resource.h"
+#include "core/array.h"
 #include "core/calc.h"
 #include "core/image.h"
+#include "core/log.h"
 #include "empire/trade_prices.h"
 #include "figure/figure.h"
 #include "game/tutorial.h"
 #include "map/image.h"
 #include "scenario/property.h"
 
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
 #define INFINITE 10000
 
-int building_warehouse_get_space_info(building *warehouse)
+#define INVENTORY_ARRAY_SIZE_STEP 500
+
+typedef enum {
+    WAREHOUSES_ALL = -1,
+    WAREHOUSES_STORING = 0, // warehouses that have some of the resource
+    WAREHOUSES_WITH_ROOM = 1, // warehouses with a space that can take the resource
+    NUM_WAREHOUSE_LISTS = 2
+} warehouse_list;
+
+typedef struct {
+    short loads[RESOURCE_MAX];
+    short free_loads[RESOURCE_MAX];
+    short spaces_with_room[RESOURCE_MAX];
+    short total_loads;
+    short empty_spaces;
+    short unloaded_spaces;
+    short missing_spaces;
+} warehouse_inventory;
+
+static struct {
+    int is_valid;
+    array(warehouse_inventory) warehouses; // indexed by building id
+    uint32_t *lists; // one bit per building id for every list and resource
+    int list_words;
+    int list_capacity;
+} inventory;
+
+static void count_inventory(building *warehouse, warehouse_inventory *inv)
 {
-    int total_loads = 0;
-    int empty_spaces = 0;
+    memset(inv, 0, sizeof(warehouse_inventory));
     building *space = warehouse;
     for (int i = 0; i < 8; i++) {
         space = building_next(space);
         if (space->id <= 0) {
-            return 0;
+            inv->missing_spaces++;
+            continue;
         }
-        if (space->subtype.warehouse_resource_id) {
-            total_loads += space->loads_stored;
+        int resource = space->subtype.warehouse_resource_id;
+        if (resource) {
+            inv->total_loads += space->loads_stored;
+            if (resource < RESOURCE_MAX) {
+                inv->loads[resource] += space->loads_stored;
+                inv->free_loads[resource] += 4 - space->loads_stored;
+                if (space->loads_stored < 4) {
+                    inv->spaces_with_room[resource]++;
+                }
+            }
         } else {
-            empty_spaces++;
+            inv->empty_spaces++;
+        }
+        if (space->loads_stored <= 0) {
+            inv->unloaded_spaces++;
+        }
+    }
+}
+
+static uint32_t *get_list(warehouse_list list, int resource)
+{
+    return &inventory.lists[(list * RESOURCE_MAX + resource) * inventory.list_words];
+}
+
+static void set_listed(warehouse_list list, int resource, int building_id, int listed)
+{
+    uint32_t *words = get_list(list, resource);
+    if (listed) {
+        words[building_id >> 5] |= 1u << (building_id & 31);
+    } else {
+        words[building_id >> 5] &= ~(1u << (building_id & 31));
+    }
+}
+
+static void update_inventory(building *warehouse)
+{
+    if (!inventory.is_valid || warehouse->type != BUILDING_WAREHOUSE) {
+        return;
+    }
+    warehouse_inventory *inv = array_item(inventory.warehouses, warehouse->id);
+    count_inventory(warehouse, inv);
+    int has_empty_space = inv->empty_spaces > 0 || inv->missing_spaces > 0;
+    for (int r = RESOURCE_MIN; r < RESOURCE_MAX; r++) {
+        set_listed(WAREHOUSES_STORING, r, warehouse->id, inv->loads[r] > 0);
+        set_listed(WAREHOUSES_WITH_ROOM, r, warehouse->id, has_empty_space || inv->spaces_with_room[r] > 0);
+    }
+}
+
+static int allocate_lists(void)
+{
+    int words = (building_count() >> 5) + 1;
+    int capacity = words * NUM_WAREHOUSE_LISTS * RESOURCE_MAX;
+    if (capacity > inventory.list_capacity) {
+        uint32_t *lists = realloc(inventory.lists, capacity * sizeof(uint32_t));
+        if (!lists) {
+            return 0;
         }
+        inventory.lists = lists;
+        inventory.list_capacity = capacity;
     }
-    if (empty_spaces > 0) {
+    inventory.list_words = words;
+    memset(inventory.lists, 0, capacity * sizeof(uint32_t));
+    return 1;
+}
+
+static int rebuild_inventory(void)
+{
+    if (!array_init(inventory.warehouses, INVENTORY_ARRAY_SIZE_STEP, 0, 0) ||
+        !array_expand(inventory.warehouses, building_count()) || !allocate_lists()) {
+        log_error("Unable to allocate memory for the warehouse inventory", 0, 0);
+        return 0;
+    }
+    inventory.warehouses.size = building_count();
+    inventory.is_valid = 1;
+    for (building *b = building_first_of_type(BUILDING_WAREHOUSE); b; b = b->next_of_type) {
+        update_inventory(b);
+    }
+    return 1;
+}
+
+static int ensure_inventory(void)
+{
+    return inventory.is_valid || rebuild_inventory();
+}
+
+void building_warehouse_invalidate_inventory(void)
+{
+    inventory.is_valid = 0;
+}
+
+static const warehouse_inventory *get_inventory(building *warehouse)
+{
+    static warehouse_inventory uncached;
+    if (warehouse->type == BUILDING_WAREHOUSE && ensure_inventory()) {
+        return array_item(inventory.warehouses, warehouse->id);
+    }
+    count_inventory(warehouse, &uncached);
+    return &uncached;
+}
+
+static building *next_warehouse(warehouse_list list, int resource, building *b)
+{
+    if (list == WAREHOUSES_ALL || !ensure_inventory()) {
+        return b ? b->next_of_type : building_first_of_type(BUILDING_WAREHOUSE);
+    }
+    const uint32_t *words = get_list(list, resource);
+    int id = b ? b->id + 1 : 0;
+    for (int word = id >> 5; word < inventory.list_words; word++, id = word << 5) {
+        uint32_t bits = words[word] >> (id & 31);
+        while (bits) {
+            if (bits & 1) {
+                return building_get(id);
+            }
+            bits >>= 1;
+            id++;
+        }
+    }
+    return 0;
+}
+
+int building_warehouse_get_space_info(building *warehouse)
+{
+    const warehouse_inventory *inv = get_inventory(warehouse);
+    if (inv->missing_spaces) {
+        return 0;
+    }
+    if (inv->empty_spaces > 0) {
         return WAREHOUSE_ROOM;
-    } else if (total_loads < FULL_WAREHOUSE) {
+    } else if (inv->total_loads < FULL_WAREHOUSE) {
         return WAREHOUSE_SOME_ROOM;
     } else {
         return WAREHOUSE_FULL;
@@ -46,18 +199,11 @@ int building_warehouse_get_space_info(building *warehouse)
 
 int building_warehouse_get_amount(building *warehouse, int resource)
 {
-    int loads = 0;
-    building *space = warehouse;
-    for (int i = 0; i < 8; i++) {
-        space = building_next(space);
-        if (space->id <= 0) {
-            return 0;
-        }
-        if (space->subtype.warehouse_resource_id && space->subtype.warehouse_resource_id == resource) {
-            loads += space->loads_stored;
-        }
+    const warehouse_inventory *inv = get_inventory(warehouse);
+    if (inv->missing_spaces) {
+        return 0;
     }
-    return loads;
+    return inv->loads[resource];
 }
 
 int building_warehouse_add_resource(building *b, int resource)
@@ -113,6 +259,7 @@ int building_warehouse_add_resource(building *b, int resource)
     b->loads_stored++;
     tutorial_on_add_to_warehouse();
     building_warehouse_space_set_image(b, resource);
+    update_inventory(building_main(b));
     return 1;
 }
 
@@ -126,10 +273,7 @@ int building_warehouse_remove_resource(building *warehouse, int resource, int am
         return amount;
     }
     building *space = warehouse;
-    for (int i = 0; i < 8; i++) {
-        if (amount <= 0) {
-            return 0;
-        }
+    for (int i = 0; i < 8 && amount > 0; i++) {
         space = building_next(space);
         if (space->id <= 0) {
             continue;
@@ -149,7 +293,8 @@ int building_warehouse_remove_resource(building *warehouse, int resource, int am
         }
         building_warehouse_space_set_image(space, resource);
     }
-    return amount;
+    update_inventory(warehouse);
+    return amount > 0 ? amount : 0;
 }
 
 void building_warehouse_remove_resource_curse(building *warehouse, int amount)
@@ -177,6 +322,7 @@ void building_warehouse_remove_resource_curse(building *warehouse, int amount)
         }
         building_warehouse_space_set_image(space, resource);
     }
+    update_inventory(warehouse);
 }
 
 void building_warehouse_space_set_image(building *space, int resource)
@@ -202,6 +348,7 @@ void building_warehouse_space_add_import(building *space, int resource, int land
     city_finance_process_import(price);
 
     building_warehouse_space_set_image(space, resource);
+    update_inventory(building_main(space));
 }
 
 void building_warehouse_space_remove_export(building *space, int resource, int land_trader)
@@ -216,6 +363,7 @@ void building_warehouse_space_remove_export(building *space, int resource, int l
     city_finance_process_export(price);
 
     building_warehouse_space_set_image(space, resource);
+    update_inventory(building_main(space));
 }
 
 static building *get_next_warehouse(void)
@@ -422,15 +570,8 @@ int building_warehouse_accepts_storage(building *b, int resource, int *understaf
         }
         return 0;
     }
-    building *space = b;
-    for (int t = 0; t < 8; t++) {
-        space = building_next(space);
-        if (space->subtype.warehouse_resource_id == RESOURCE_NONE || // empty warehouse space
-            (space->subtype.warehouse_resource_id == resource && space->loads_stored < 4)) {
-            return 1;
-        }
-    }
-    return 0;
+    const warehouse_inventory *inv = get_inventory(b);
+    return inv->empty_spaces > 0 || inv->missing_spaces > 0 || inv->spaces_with_room[resource] > 0;
 }
 
 int building_warehouse_for_storing(int src_building_id, int x, int y, int resource, int road_network_id,
@@ -438,7 +579,9 @@ int building_warehouse_for_storing(int src_building_id, int x, int y, int resour
 {
     int min_dist = INFINITE;
     int min_building_id = 0;
-    for (building *b = building_first_of_type(BUILDING_WAREHOUSE); b; b = b->next_of_type) {
+    // the understaffed count includes warehouses without room, so all of them have to be checked then
+    warehouse_list list = understaffed ? WAREHOUSES_ALL : WAREHOUSES_WITH_ROOM;
+    for (building *b = next_warehouse(list, resource, 0); b; b = next_warehouse(list, resource, b)) {
         if (b->id == src_building_id || b->road_network_id != road_network_id ||
             !building_warehouse_accepts_storage(b, resource, understaffed)) {
             continue;
@@ -460,24 +603,15 @@ int building_warehouse_for_storing(int src_building_id, int x, int y, int resour
 
 int building_warehouse_amount_can_get_from(building *destination, int resource)
 {
-    int loads_stored = 0;
-    building *space = destination;
-    for (int t = 0; t < 8; t++) {
-        space = building_next(space);
-        if (space->id > 0 && space->loads_stored > 0) {
-            if (space->subtype.warehouse_resource_id == resource) {
-                loads_stored += space->loads_stored;
-            }
-        }
-    }
-    return loads_stored;
+    return get_inventory(destination)->loads[resource];
 }
 
 int building_warehouse_for_getting(building *src, int resource, map_point *dst)
 {
     int min_dist = INFINITE;
     building *min_building = 0;
-    for (building *b = building_first_of_type(BUILDING_WAREHOUSE); b; b = b->next_of_type) {
+    for (building *b = next_warehouse(WAREHOUSES_STORING, resource, 0); b;
+        b = next_warehouse(WAREHOUSES_STORING, resource, b)) {
         if (b->state != BUILDING_STATE_IN_USE || b->has_plague) {
             continue;
         }
@@ -510,7 +644,9 @@ int building_warehouse_with_resource(int src_building_id, int x, int y, int reso
 {
     int min_dist = INFINITE;
     building *min_building = 0;
-    for (building *b = building_first_of_type(BUILDING_WAREHOUSE); b; b = b->next_of_type) {
+    // the understaffed count includes warehouses without the resource, so all of them have to be checked then
+    warehouse_list list = understaffed ? WAREHOUSES_ALL : WAREHOUSES_STORING;
+    for (building *b = next_warehouse(list, resource, 0); b; b = next_warehouse(list, resource, b)) {
         if (b->state != BUILDING_STATE_IN_USE || b->has_plague) {
             continue;
         }
@@ -525,16 +661,7 @@ int building_warehouse_with_resource(int src_building_id, int x, int y, int reso
             }
             continue;
         }
-        int loads_stored = 0;
-        building *space = b;
-        for (int t = 0; t < 8; t++) {
-            space = building_next(space);
-            if (space->id > 0 && space->loads_stored > 0) {
-                if (space->subtype.warehouse_resource_id == resource) {
-                    loads_stored += space->loads_stored;
-                }
-            }
-        }
+        int loads_stored = building_warehouse_amount_can_get_from(b, resource);
         if (loads_stored > 0) {
             int dist = calc_maximum_distance(b->x, b->y, x, y);
             dist -= 4 * loads_stored;
@@ -554,62 +681,38 @@ int building_warehouse_with_resource(int src_building_id, int x, int y, int reso
     }
 }
 
-static int determine_granary_accept_foods(int resources[RESOURCE_MAX_FOOD], int road_network)
+static int count_granaries_for_foods(granary_food_list list, int resources[RESOURCE_MAX_FOOD], int road_network)
 {
     if (scenario_property_rome_supplies_wheat()) {
         return 0;
     }
-    for (int i = 0; i < RESOURCE_MAX_FOOD; i++) {
-        resources[i] = 0;
-    }
-    int can_accept = 0;
-    for (building *b = building_first_of_type(BUILDING_GRANARY); b; b = b->next_of_type) {
-        if (b->state != BUILDING_STATE_IN_USE || !b->has_road_access || b->has_plague || road_network != b->road_network_id) {
-            continue;
-        }
-        int pct_workers = calc_percentage(b->num_workers, model_get_building(b->type)->laborers);
-        if (pct_workers >= 100 && b->data.granary.resource_stored[RESOURCE_NONE] >= 100) {
-            const building_storage *s = building_storage_get(b->storage_id);
-            if (!s->empty_all) {
-                for (int r = 0; r < RESOURCE_MAX_FOOD; r++) {
-                    if (!building_granary_is_not_accepting(r, b)) {
-                        resources[r]++;
-                        can_accept = 1;
-                    }
-                }
+    int found = 0;
+    for (int r = 0; r < RESOURCE_MAX_FOOD; r++) {
+        resources[r] = 0;
+        for (building *b = building_granary_next_for_food(list, r, 0); b;
+            b = building_granary_next_for_food(list, r, b)) {
+            if (b->state != BUILDING_STATE_IN_USE || !b->has_road_access || b->has_plague ||
+                road_network != b->road_network_id) {
+                continue;
+            }
+            int pct_workers = calc_percentage(b->num_workers, model_get_building(b->type)->laborers);
+            if (pct_workers >= 100) {
+                resources[r]++;
+                found = 1;
             }
         }
     }
-    return can_accept;
+    return found;
+}
+
+static int determine_granary_accept_foods(int resources[RESOURCE_MAX_FOOD], int road_network)
+{
+    return count_granaries_for_foods(GRANARIES_ACCEPTING, resources, road_network);
 }
 
 static int determine_granary_get_foods(int resources[RESOURCE_MAX_FOOD], int road_network)
 {
-    if (scenario_property_rome_supplies_wheat()) {
-        return 0;
-    }
-    for (int i = 0; i < RESOURCE_MAX_FOOD; i++) {
-        resources[i] = 0;
-    }
-    int can_get = 0;
-    for (building *b = building_first_of_type(BUILDING_GRANARY); b; b = b->next_of_type) {
-        if (b->state != BUILDING_STATE_IN_USE || !b->has_road_access || b->has_plague || road_network != b->road_network_id) {
-            continue;
-        }
-        int pct_workers = calc_percentage(b->num_workers, model_get_building(b->type)->laborers);
-        if (pct_workers >= 100 && b->data.granary.resource_stored[RESOURCE_NONE] > 100) {
-            const building_storage *s = building_storage_get(b->storage_id);
-            if (!s->empty_all) {
-                for (int r = 0; r < RESOURCE_MAX_FOOD; r++) {
-                    if (building_granary_is_getting(r, b)) {
-                        resources[r]++;
-                        can_get = 1;
-                    }
-                }
-            }
-        }
-    }
-    return can_get;
+    return count_granaries_for_foods(GRANARIES_GETTING, resources, road_network);
 }
 
 static int contains_non_stockpiled_food(building *space, const int *resources)
@@ -649,29 +752,9 @@ int building_warehouse_determine_worker_task(building *warehouse, int *resource)
         if (!building_warehouse_is_getting(r, warehouse) || city_resource_is_stockpiled(r)) {
             continue;
         }
-        int loads_stored = 0;
-        space = warehouse;
-        for (int i = 0; i < 8; i++) {
-            space = building_next(space);
-            if (space->id > 0 && space->loads_stored > 0) {
-                if (space->subtype.warehouse_resource_id == r) {
-                    loads_stored += space->loads_stored;
-                }
-            }
-        }
-        int room = 0;
-        space = warehouse;
-        for (int i = 0; i < 8; i++) {
-            space = building_next(space);
-            if (space->id > 0) {
-                if (space->loads_stored <= 0) {
-                    room += 4;
-                }
-                if (space->subtype.warehouse_resource_id == r) {
-                    room += 4 - space->loads_stored;
-                }
-            }
-        }
+        const warehouse_inventory *inv = get_inventory(warehouse);
+        int loads_stored = inv->loads[r];
+        int room = 4 * inv->unloaded_spaces + inv->free_loads[r];
         if (room >= 4 && (loads_stored <= 4 || ((building_warehouse_get_acceptable_quantity(r, warehouse) - loads_stored) >= 4)) && city_resource_count(r) - loads_stored >= 4) {
             if (!building_warehouse_for_getting(warehouse, r, 0)) {
                 continue;
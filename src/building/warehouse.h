@@ -60,4 +60,6 @@ int building_warehouse_with_resource(int src_building_id, int x, int y, int reso
 
 int building_warehouse_determine_worker_task(building *warehouse, int *resource);
 
+void building_warehouse_invalidate_inventory(void);
+
 #endif // BUILDING_WAREHOUSE_H
@@ -547,9 +547,13 @@ static void save_main_data(buffer *main)
     for (int i = 0; i < 232; i++) {
         buffer_write_i8(main, city_data.unused.unknown_464c[i]);
     }
+    // expanded ids
+    for (int i = 0; i < 10; i++) {
+        buffer_write_i32(main, city_data.building.working_dock_ids[i]);
+    }
 }
 
-static void load_main_data(buffer *main, int has_separate_import_limits)
+static void load_main_data(buffer *main, int has_separate_import_limits, int has_32_bit_dock_ids)
 {
     buffer_read_raw(main, city_data.unused.other_player, 18068);
     city_data.unused.unknown_00a0 = buffer_read_i8(main);
@@ -1054,6 +1058,11 @@ static void load_main_data(buffer *main, int has_separate_import_limits)
     for (int i = 0; i < 232; i++) {
         city_data.unused.unknown_464c[i] = buffer_read_i8(main);
     }
+    if (has_32_bit_dock_ids) {
+        for (int i = 0; i < 10; i++) {
+            city_data.building.working_dock_ids[i] = buffer_read_i32(main);
+        }
+    }
     if (!has_separate_import_limits) {
         for (int i = RESOURCE_MIN; i < RESOURCE_MAX; i++) {
             if (city_data.resource.trade_status[i] == TRADE_STATUS_IMPORT) {
@@ -1103,9 +1112,9 @@ void city_data_save_state(buffer *main, buffer *faction, buffer *faction_unknown
 }
 
 void city_data_load_state(buffer *main, buffer *faction, buffer *faction_unknown, buffer *graph_order,
-    buffer *entry_exit_xy, buffer *entry_exit_grid_offset, int has_separate_import_limits)
+    buffer *entry_exit_xy, buffer *entry_exit_grid_offset, int has_separate_import_limits, int has_32_bit_dock_ids)
 {
-    load_main_data(main, has_separate_import_limits);
+    load_main_data(main, has_separate_import_limits, has_32_bit_dock_ids);
 
     city_data.unused.faction_id = buffer_read_i32(faction);
     city_data.unused.faction_bytes[0] = buffer_read_i8(faction_unknown);
@@ -47,7 +47,7 @@ extern struct city_data_t {
         int32_t caravanserai_building_id;
         int32_t shipyard_boats_requested;
         int16_t working_docks;
-        int16_t working_dock_ids[10];
+        int32_t working_dock_ids[10];
         int32_t mission_post_operational;
         map_point main_native_meeting;
         int8_t unknown_value;
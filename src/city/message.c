@@ -271,6 +271,7 @@ void city_message_process_queue(void)
 void city_message_sort_and_compact(void)
 {
     for (int i = 0; i < MAX_MESSAGES; i++) {
+        int swapped = 0;
         for (int a = 0; a < MAX_MESSAGES - 1; a++) {
             int swap = 0;
             if (data.messages[a].message_type) {
@@ -286,8 +287,13 @@ void city_message_sort_and_compact(void)
                 city_message tmp_message = data.messages[a];
                 data.messages[a] = data.messages[a+1];
                 data.messages[a+1] = tmp_message;
+                swapped = 1;
             }
         }
+        if (!swapped) {
+            // already sorted, further passes won't change anything
+            break;
+        }
     }
     data.total_messages = 0;
     for (int i = 0; i < MAX_MESSAGES; i++) {
@@ -60,6 +60,9 @@ static const char *ini_keys[] = {
     "gameplay_change_disable_infinite_wolves_spawning",
     "gameplay_change_romers_dont_skip_corners",
     "gameplay_change_yearly_autosave",
+    "gameplay_change_hierarchical_routing",
+    "gameplay_change_incremental_desirability",
+    "fast_autosaves",
 };
 
 static const char *ini_string_keys[] = {
@@ -52,6 +52,9 @@ typedef enum {
     CONFIG_GP_CH_DISABLE_INFINITE_WOLVES_SPAWNING,
     CONFIG_GP_CH_ROAMERS_DONT_SKIP_CORNERS,
     CONFIG_GP_CH_YEARLY_AUTOSAVE,
+    CONFIG_GP_CH_HIERARCHICAL_ROUTING,
+    CONFIG_GP_CH_INCREMENTAL_DESIRABILITY,
+    CONFIG_GENERAL_FAST_AUTOSAVES,
     CONFIG_MAX_ENTRIES
 } config_key;
 
@@ -89,3 +89,8 @@ int file_remove(const char *filename)
 {
     return platform_file_manager_remove_file(filename);
 }
+
+int file_rename(const char *filename, const char *new_filename)
+{
+    return platform_file_manager_rename_file(filename, new_filename);
+}
@@ -85,4 +85,12 @@ int file_exists(const char *filename, int localizable);
  */
 int file_remove(const char *filename);
 
+/**
+ * Rename a file, replacing the destination if it exists
+ * @param filename Filename to rename
+ * @param new_filename New filename
+ * @return boolean true if the file was renamed, false otherwise
+ */
+int file_rename(const char *filename, const char *new_filename);
+
 #endif // CORE_FILE_H
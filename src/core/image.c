@@ -6,6 +6,7 @@
 #include "core/image_packer.h"
 #include "core/io.h"
 #include "core/log.h"
+#include "core/thread.h"
 #include "graphics/font.h"
 #include "graphics/renderer.h"
 
@@ -39,6 +40,9 @@
 
 #define IMAGE_TYPE_ISOMETRIC 30
 
+#define MAX_DECODE_JOBS 16
+#define MIN_IMAGES_PER_DECODE_JOB 200
+
 enum {
     NO_EXTRA_FONT = 0,
     FULL_CHARSET_IN_FONT = 1,
@@ -55,6 +59,24 @@ typedef struct {
     int original_width;
 } image_draw_data;
 
+typedef enum {
+    DECODE_STAGE_CROP = 0,
+    DECODE_STAGE_CONVERT = 1
+} decode_stage;
+
+typedef struct {
+    decode_stage stage;
+    image *images;
+    image_draw_data *draw_datas;
+    int num_images;
+    atlas_type type;
+    const image_atlas_data *atlas_data;
+    uint8_t *data;
+    int data_size;
+    int first_image;
+    int image_step;
+} decode_job;
+
 typedef struct {
     int width;
     int height;
@@ -309,6 +331,24 @@ static int prepare_images(buffer *buf, image *images, image_draw_data *draw_data
 }
 
 static void convert_compressed(buffer *buf, const image *img, int buf_length, color_t *dst, int dst_width);
+static void run_decode_jobs(decode_stage stage, image *images, image_draw_data *draw_datas, int num_images,
+    atlas_type type, buffer *buf, const image_atlas_data *atlas_data);
+
+static void crop_image(buffer *buf, image *img, image_draw_data *draw_data, int reduce_width)
+{
+    if (is_external(img) || img->is_isometric || !draw_data->is_compressed) {
+        return;
+    }
+    draw_data->buffer = malloc(img->width * img->height * sizeof(color_t));
+    if (!draw_data->buffer) {
+        return;
+    }
+    draw_data->original_width = img->width;
+    memset(draw_data->buffer, 0, img->width * img->height * sizeof(color_t));
+    buffer_set(buf, draw_data->offset);
+    convert_compressed(buf, img, draw_data->data_length, draw_data->buffer, img->width);
+    image_crop(img, draw_data->buffer, reduce_width);
+}
 
 static int crop_and_pack_images(buffer *buf, image *images, image_draw_data *draw_datas,
     int num_images, atlas_type type)
@@ -334,22 +374,14 @@ static int crop_and_pack_images(buffer *buf, image *images, image_draw_data *dra
         } else {
             draw_data->offset = offset;
             offset += draw_data->data_length;
+        }
+    }
 
-            if (!img->is_isometric && draw_data->is_compressed) {
-                draw_data->buffer = malloc(img->width * img->height * sizeof(color_t));
-                if (draw_data->buffer) {
-                    int reduce_width = type != ATLAS_FONT;
-                    if (type == ATLAS_MAIN) {
-                        reduce_width = i < image_group(GROUP_FONT) || i >= image_group(GROUP_FONT) + BASE_FONT_ENTRIES;
-                    }
-                    draw_data->original_width = img->width;
-                    memset(draw_data->buffer, 0, img->width * img->height * sizeof(color_t));
-                    buffer_set(buf, draw_data->offset);
-                    convert_compressed(buf, img, draw_data->data_length, draw_data->buffer, img->width);
-                    image_crop(img, draw_data->buffer, reduce_width);
-                }
-            }
+    run_decode_jobs(DECODE_STAGE_CROP, images, draw_datas, num_images, type, buf, 0);
 
+    for (int i = 1; i < num_images; i++) {
+        image *img = &images[i];
+        if (!is_external(img)) {
             image_packer_rect *rect = &data.packer.rects[i];
             rect->input.width = img->width;
             rect->input.height = img->height;
@@ -473,35 +505,103 @@ static void convert_isometric_footprint(buffer *buf, const image *img, color_t *
     }
 }
 
-static void convert_images(image *images, image_draw_data *draw_datas, int size, buffer *buf,
-    const image_atlas_data *atlas_data)
+static void convert_image(buffer *buf, image *img, image_draw_data *draw_data, const image_atlas_data *atlas_data)
 {
-    for (int i = 0; i < size; i++) {
-        image *img = &images[i];
-        image_draw_data *draw_data = &draw_datas[i];
-        if (is_external(img)) {
-            continue;
+    if (is_external(img)) {
+        return;
+    }
+    buffer_set(buf, draw_data->offset);
+    color_t *dst = atlas_data->buffers[img->atlas.id & IMAGE_ATLAS_BIT_MASK];
+    int dst_width = atlas_data->image_widths[img->atlas.id & IMAGE_ATLAS_BIT_MASK];
+    if (draw_data->is_compressed) {
+        if (draw_data->buffer) {
+            copy_compressed(img, draw_data, dst, dst_width);
+            free(draw_data->buffer);
+            draw_data->buffer = 0;
+        } else {
+            convert_compressed(buf, img, draw_data->data_length, dst, dst_width);
         }
-        buffer_set(buf, draw_data->offset);
-        color_t *dst = atlas_data->buffers[img->atlas.id & IMAGE_ATLAS_BIT_MASK];
-        int dst_width = atlas_data->image_widths[img->atlas.id & IMAGE_ATLAS_BIT_MASK];
-        if (draw_data->is_compressed) {
-            if (draw_data->buffer) {
-                copy_compressed(img, draw_data, dst, dst_width);
-                free(draw_data->buffer);
-                draw_data->buffer = 0;
-            } else {
-                convert_compressed(buf, img, draw_data->data_length, dst, dst_width);
-            }
-        } else if (img->top_height) {
-            convert_isometric_footprint(buf, img, dst, dst_width);
-            convert_compressed(buf, img, draw_data->data_length - draw_data->uncompressed_length, dst, dst_width);
-        } else if (img->is_isometric) {
-            convert_isometric_footprint(buf, img, dst, dst_width);
+    } else if (img->top_height) {
+        convert_isometric_footprint(buf, img, dst, dst_width);
+        convert_compressed(buf, img, draw_data->data_length - draw_data->uncompressed_length, dst, dst_width);
+    } else if (img->is_isometric) {
+        convert_isometric_footprint(buf, img, dst, dst_width);
+    } else {
+        convert_uncompressed(buf, img, dst, dst_width);
+    }
+}
+
+static int should_reduce_width(int image_index, atlas_type type)
+{
+    if (type == ATLAS_MAIN) {
+        return image_index < image_group(GROUP_FONT) || image_index >= image_group(GROUP_FONT) + BASE_FONT_ENTRIES;
+    }
+    return type != ATLAS_FONT;
+}
+
+static int decode_images(void *job_data)
+{
+    decode_job *job = job_data;
+    buffer buf;
+    buffer_init(&buf, job->data, job->data_size);
+    // Every image is decoded into its own buffer or its own atlas area, so the jobs never touch the same pixels
+    int first = job->stage == DECODE_STAGE_CROP ? 1 : 0;
+    for (int i = first + job->first_image; i < job->num_images; i += job->image_step) {
+        if (job->stage == DECODE_STAGE_CROP) {
+            crop_image(&buf, &job->images[i], &job->draw_datas[i], should_reduce_width(i, job->type));
         } else {
-            convert_uncompressed(buf, img, dst, dst_width);
+            convert_image(&buf, &job->images[i], &job->draw_datas[i], job->atlas_data);
         }
     }
+    return 0;
+}
+
+static void run_decode_jobs(decode_stage stage, image *images, image_draw_data *draw_datas, int num_images,
+    atlas_type type, buffer *buf, const image_atlas_data *atlas_data)
+{
+    int num_jobs = thread_get_core_count();
+    if (num_jobs > MAX_DECODE_JOBS) {
+        num_jobs = MAX_DECODE_JOBS;
+    }
+    if (num_jobs > num_images / MIN_IMAGES_PER_DECODE_JOB) {
+        num_jobs = num_images / MIN_IMAGES_PER_DECODE_JOB;
+    }
+    if (num_jobs < 1) {
+        num_jobs = 1;
+    }
+    decode_job jobs[MAX_DECODE_JOBS];
+    thread *threads[MAX_DECODE_JOBS];
+    for (int i = 0; i < num_jobs; i++) {
+        decode_job *job = &jobs[i];
+        job->stage = stage;
+        job->images = images;
+        job->draw_datas = draw_datas;
+        job->num_images = num_images;
+        job->type = type;
+        job->atlas_data = atlas_data;
+        job->data = buf->data;
+        job->data_size = buf->size;
+        // Interleave the images so all jobs get a similar mix of small and large images
+        job->first_image = i;
+        job->image_step = num_jobs;
+    }
+    for (int i = 1; i < num_jobs; i++) {
+        threads[i] = thread_create(decode_images, &jobs[i]);
+    }
+    decode_images(&jobs[0]);
+    for (int i = 1; i < num_jobs; i++) {
+        if (threads[i]) {
+            thread_wait(threads[i]);
+        } else {
+            decode_images(&jobs[i]);
+        }
+    }
+}
+
+static void convert_images(image *images, image_draw_data *draw_datas, int size, atlas_type type, buffer *buf,
+    const image_atlas_data *atlas_data)
+{
+    run_decode_jobs(DECODE_STAGE_CONVERT, images, draw_datas, size, type, buf, atlas_data);
 }
 
 static void make_font_white(const image *img, const image_atlas_data *atlas_data)
@@ -602,7 +702,7 @@ int image_load_climate(int climate_id, int is_editor, int force_reload)
         return 0;
     }
 
-    convert_images(data.main, draw_data, IMAGE_MAIN_ENTRIES, &buf, atlas_data);
+    convert_images(data.main, draw_data, IMAGE_MAIN_ENTRIES, ATLAS_MAIN, &buf, atlas_data);
     free(draw_data);
     free(tmp_data);
     make_plain_fonts_white(data.main, atlas_data, image_group(GROUP_FONT));
@@ -685,7 +785,7 @@ static int load_cyrillic_fonts(void)
         return 0;
     }
 
-    convert_images(data.font, draw_data, CYRILLIC_FONT_ENTRIES, &buf, atlas_data);
+    convert_images(data.font, draw_data, CYRILLIC_FONT_ENTRIES, ATLAS_FONT, &buf, atlas_data);
     free(tmp_data);
     free(draw_data);
     make_plain_fonts_white(data.font, atlas_data, CYRILLIC_FONT_BASE_OFFSET);
@@ -970,7 +1070,7 @@ int image_load_enemy(int enemy_id)
         return 0;
     }
 
-    convert_images(data.enemy, draw_data, ENEMY_ENTRIES, &buf, atlas_data);
+    convert_images(data.enemy, draw_data, ENEMY_ENTRIES, ATLAS_ENEMY, &buf, atlas_data);
     free(tmp_data);
     free(draw_data);
     data.current_enemy = enemy_id;
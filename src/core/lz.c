@@ -0,0 +1,230 @@
+#include "core/lz.h"
+
+#include "core/log.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define LZ_HASH_BITS 12
+#define LZ_HASH_SIZE (1 << LZ_HASH_BITS)
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_OFFSET 65535
+#define LZ_RUN_MASK 15
+// the format requires the last bytes to be literals, and the last copy to start before this many bytes from the end
+#define LZ_LAST_LITERALS 5
+#define LZ_MATCH_FIND_LIMIT 12
+// after 2^LZ_SKIP_TRIGGER failed lookups the search starts skipping bytes, to quickly pass data that does not compress
+#define LZ_SKIP_TRIGGER 6
+
+static uint32_t read_u32(const uint8_t *data)
+{
+    uint32_t value;
+    memcpy(&value, data, 4);
+    return value;
+}
+
+static uint64_t read_u64(const uint8_t *data)
+{
+    uint64_t value;
+    memcpy(&value, data, 8);
+    return value;
+}
+
+static int hash(uint32_t sequence)
+{
+    return (int) ((sequence * 2654435761u) >> (32 - LZ_HASH_BITS));
+}
+
+static uint8_t *write_length(uint8_t *dst, int length)
+{
+    while (length >= 255) {
+        *dst++ = 255;
+        length -= 255;
+    }
+    *dst++ = (uint8_t) length;
+    return dst;
+}
+
+static uint8_t *write_sequence(uint8_t *dst, const uint8_t *dst_end,
+    const uint8_t *literals, int literal_length, int offset, int match_length)
+{
+    int needed = 1 + literal_length + literal_length / 255 + 1;
+    if (match_length) {
+        needed += 2 + match_length / 255 + 1;
+    }
+    if (dst_end - dst < needed) {
+        return 0;
+    }
+    uint8_t *token = dst++;
+    if (literal_length >= LZ_RUN_MASK) {
+        *token = LZ_RUN_MASK << 4;
+        dst = write_length(dst, literal_length - LZ_RUN_MASK);
+    } else {
+        *token = (uint8_t) (literal_length << 4);
+    }
+    memcpy(dst, literals, literal_length);
+    dst += literal_length;
+    if (!match_length) {
+        return dst;
+    }
+    *dst++ = (uint8_t) (offset & 0xff);
+    *dst++ = (uint8_t) (offset >> 8);
+    match_length -= LZ_MIN_MATCH;
+    if (match_length >= LZ_RUN_MASK) {
+        *token |= LZ_RUN_MASK;
+        dst = write_length(dst, match_length - LZ_RUN_MASK);
+    } else {
+        *token |= (uint8_t) match_length;
+    }
+    return dst;
+}
+
+static const uint8_t *find_match_end(const uint8_t *src, const uint8_t *match, const uint8_t *src_limit)
+{
+    while (src_limit - src >= 8 && read_u64(src) == read_u64(match)) {
+        src += 8;
+        match += 8;
+    }
+    while (src < src_limit && *src == *match) {
+        src++;
+        match++;
+    }
+    return src;
+}
+
+int lz_compress(const void *input_buffer, int input_length, void *output_buffer, int *output_length)
+{
+    const uint8_t *input = (const uint8_t *) input_buffer;
+    const uint8_t *input_end = input + input_length;
+    uint8_t *dst = (uint8_t *) output_buffer;
+    const uint8_t *dst_end = dst + *output_length;
+    const uint8_t *anchor = input;
+
+    if (input_length > LZ_MATCH_FIND_LIMIT) {
+        // positions of the last sequence with each hash; starting at zero is fine as every candidate is verified
+        int32_t table[LZ_HASH_SIZE];
+        memset(table, 0, sizeof(table));
+        const uint8_t *match_limit = input_end - LZ_LAST_LITERALS;
+        const uint8_t *search_limit = input_end - LZ_MATCH_FIND_LIMIT;
+        const uint8_t *src = input + 1;
+        while (src < search_limit) {
+            const uint8_t *match = 0;
+            int attempts = 1 << LZ_SKIP_TRIGGER;
+            while (src < search_limit) {
+                uint32_t sequence = read_u32(src);
+                int h = hash(sequence);
+                const uint8_t *candidate = input + table[h];
+                table[h] = (int32_t) (src - input);
+                if (src - candidate <= LZ_MAX_OFFSET && read_u32(candidate) == sequence) {
+                    match = candidate;
+                    break;
+                }
+                src += attempts++ >> LZ_SKIP_TRIGGER;
+            }
+            if (!match) {
+                break;
+            }
+            while (src > anchor && match > input && src[-1] == match[-1]) {
+                src--;
+                match--;
+            }
+            const uint8_t *match_end = find_match_end(src + LZ_MIN_MATCH, match + LZ_MIN_MATCH, match_limit);
+            dst = write_sequence(dst, dst_end, anchor, (int) (src - anchor),
+                (int) (src - match), (int) (match_end - src));
+            if (!dst) {
+                return 0;
+            }
+            src = anchor = match_end;
+            if (src < search_limit) {
+                table[hash(read_u32(src - 2))] = (int32_t) (src - 2 - input);
+            }
+        }
+    }
+    dst = write_sequence(dst, dst_end, anchor, (int) (input_end - anchor), 0, 0);
+    if (!dst) {
+        return 0;
+    }
+    *output_length = (int) (dst - (uint8_t *) output_buffer);
+    return 1;
+}
+
+static int read_length(const uint8_t **src, const uint8_t *src_end, int max_length, int *length)
+{
+    int byte;
+    do {
+        if (*src >= src_end) {
+            return 0;
+        }
+        byte = *(*src)++;
+        *length += byte;
+        if (*length > max_length) {
+            return 0;
+        }
+    } while (byte == 255);
+    return 1;
+}
+
+static void copy_match(uint8_t *dst, int offset, int length)
+{
+    const uint8_t *src = dst - offset;
+    // an overlapping copy repeats the bytes between src and dst, so every step can copy twice as much
+    while (length > 0) {
+        int chunk = (int) (dst - src) < length ? (int) (dst - src) : length;
+        memcpy(dst, src, chunk);
+        dst += chunk;
+        length -= chunk;
+    }
+}
+
+static int decompress(const uint8_t *src, int input_length, uint8_t *output, int *output_length)
+{
+    const uint8_t *src_end = src + input_length;
+    uint8_t *dst = output;
+    int capacity = *output_length;
+    while (src < src_end) {
+        int token = *src++;
+        int literal_length = token >> 4;
+        if (literal_length == LZ_RUN_MASK && !read_length(&src, src_end, capacity, &literal_length)) {
+            return 0;
+        }
+        if (literal_length > src_end - src || literal_length > capacity - (dst - output)) {
+            return 0;
+        }
+        memcpy(dst, src, literal_length);
+        src += literal_length;
+        dst += literal_length;
+        if (src == src_end) {
+            // the last sequence has no copy
+            break;
+        }
+        if (src_end - src < 2) {
+            return 0;
+        }
+        int offset = src[0] | (src[1] << 8);
+        src += 2;
+        if (!offset || offset > dst - output) {
+            return 0;
+        }
+        int match_length = token & LZ_RUN_MASK;
+        if (match_length == LZ_RUN_MASK && !read_length(&src, src_end, capacity, &match_length)) {
+            return 0;
+        }
+        match_length += LZ_MIN_MATCH;
+        if (match_length > capacity - (dst - output)) {
+            return 0;
+        }
+        copy_match(dst, offset, match_length);
+        dst += match_length;
+    }
+    *output_length = (int) (dst - output);
+    return 1;
+}
+
+int lz_decompress(const void *input_buffer, int input_length, void *output_buffer, int *output_length)
+{
+    if (!decompress((const uint8_t *) input_buffer, input_length, (uint8_t *) output_buffer, output_length)) {
+        log_error("LZ Error uncompressing.", 0, 0);
+        return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,30 @@
+#ifndef CORE_LZ_H
+#define CORE_LZ_H
+
+/**
+ * @file
+ * Fast byte oriented LZ77 compression, in the LZ4 block format.
+ * Compresses worse than zip, but compresses and decompresses many times faster.
+ */
+
+/**
+ * Compresses the input buffer.
+ * @param input_buffer Input buffer to compress
+ * @param input_length Length of input buffer
+ * @param output_buffer Output buffer to write the compressed data to
+ * @param output_length IN: available length of the output buffer, OUT: written bytes
+ * @return boolean true on success, false when the output buffer is too small
+ */
+int lz_compress(const void *input_buffer, int input_length, void *output_buffer, int *output_length);
+
+/**
+ * Decompresses the input buffer
+ * @param input_buffer Input buffer to decompress
+ * @param input_length Length of the input buffer
+ * @param output_buffer Output buffer to write decompressed data to
+ * @param output_length IN: available length of the output buffer, OUT: written bytes
+ * @return boolean true on success, false on error
+ */
+int lz_decompress(const void *input_buffer, int input_length, void *output_buffer, int *output_length);
+
+#endif // CORE_LZ_H
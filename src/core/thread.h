@@ -0,0 +1,39 @@
+#ifndef CORE_THREAD_H
+#define CORE_THREAD_H
+
+/**
+ * @file
+ * Worker threads, implemented by the platform.
+ */
+
+typedef struct thread thread;
+
+/**
+ * Starts running a function on a new thread
+ * @param function Function to run
+ * @param data Data to pass to the function
+ * @return The new thread, or 0 if threads are not available. In that case the function is not run.
+ */
+thread *thread_create(int (*function)(void *data), void *data);
+
+/**
+ * Checks whether the function of the thread has returned
+ * @param t Thread
+ * @return 1 if the function has returned, 0 if it is still running
+ */
+int thread_is_finished(thread *t);
+
+/**
+ * Waits for the function of the thread to return and frees the thread
+ * @param t Thread
+ * @return Return value of the function
+ */
+int thread_wait(thread *t);
+
+/**
+ * Gets the number of CPU cores, to decide how many threads to use for work that can be split
+ * @return Number of logical CPU cores, at least 1
+ */
+int thread_get_core_count(void);
+
+#endif // CORE_THREAD_H
@@ -16,6 +16,14 @@ enum {
     PK_EOF = 773,
 };
 
+#define PK_HASH_BITS 12
+#define PK_HASH_SIZE (1 << PK_HASH_BITS)
+#define PK_NO_POSITION -1
+#define PK_FAST_MAX_CHAIN 32
+#define PK_FAST_NICE_LENGTH 128
+#define PK_FAST_LAZY_LIMIT 6
+#define PK_BEST_LAZY_LIMIT 8
+
 struct pk_token {
     int stop;
 
@@ -40,8 +48,10 @@ struct pk_comp_buffer {
     int dictionary_size;
     unsigned int copy_offset_extra_mask;
     int current_output_bits_used;
+    zip_compression_level level;
 
     uint8_t input_data[8708];
+    int input_data_end;
     uint8_t output_data[2050];
     int output_ptr;
 
@@ -49,28 +59,20 @@ struct pk_comp_buffer {
     uint16_t analyze_index[8708];
     signed short long_matcher[518];
 
+    int16_t hash_head[PK_HASH_SIZE];
+    int16_t hash_prev[8708];
+    int next_index_to_hash;
+
     uint16_t codeword_values[774];
     uint8_t codeword_bits[774];
 };
 
-struct pk_decomp_buffer {
-    pk_input_func *input_func;
-    pk_output_func *output_func;
-    struct pk_token *token;
-
-    int window_size;
-    int dictionary_size;
-    uint16_t current_input_byte;
-    int current_input_bits_available;
-
-    int input_buffer_ptr;
-    int input_buffer_end;
-    int output_buffer_ptr;
-    uint8_t input_buffer[2048];
-    uint8_t output_buffer[8708]; // 2x 4096 (max dict size) + 516 for copying
-
-    uint8_t copy_offset_jump_table[256];
-    uint8_t copy_length_jump_table[256];
+struct pk_bit_reader {
+    const uint8_t *data;
+    int length;
+    int next_byte;
+    uint64_t bits;
+    int bits_available;
 };
 
 struct pk_copy_length_offset {
@@ -342,11 +344,92 @@ static void pk_implode_determine_copy(struct pk_comp_buffer *buf, int input_inde
     // never reached
 }
 
+static int pk_implode_hash(const uint8_t *data)
+{
+    uint32_t value = data[0] | (data[1] << 8) | (data[2] << 16);
+    return (int) ((value * 2654435761u) >> (32 - PK_HASH_BITS));
+}
+
+static void pk_implode_hash_up_to(struct pk_comp_buffer *buf, int input_index)
+{
+    // a copy needs at least three bytes, so the last two bytes of the data are never hashed
+    int end = input_index < buf->input_data_end - 2 ? input_index : buf->input_data_end - 2;
+    for (int index = buf->next_index_to_hash; index < end; index++) {
+        int hash_value = pk_implode_hash(&buf->input_data[index]);
+        buf->hash_prev[index] = buf->hash_head[hash_value];
+        buf->hash_head[hash_value] = (int16_t) index;
+    }
+    if (input_index > buf->next_index_to_hash) {
+        buf->next_index_to_hash = input_index;
+    }
+}
+
+static void pk_implode_slide_hash(struct pk_comp_buffer *buf, int distance)
+{
+    for (int i = 0; i < PK_HASH_SIZE; i++) {
+        buf->hash_head[i] = (int16_t) (buf->hash_head[i] >= distance ? buf->hash_head[i] - distance : PK_NO_POSITION);
+    }
+    int size = buf->next_index_to_hash - distance;
+    for (int i = 0; i < size; i++) {
+        int prev = buf->hash_prev[i + distance];
+        buf->hash_prev[i] = (int16_t) (prev >= distance ? prev - distance : PK_NO_POSITION);
+    }
+    buf->next_index_to_hash = size;
+}
+
+static void pk_implode_determine_copy_fast(struct pk_comp_buffer *buf, int input_index,
+    struct pk_copy_length_offset *copy)
+{
+    pk_implode_hash_up_to(buf, input_index);
+    copy->length = 0;
+    int max_length = buf->input_data_end - input_index;
+    if (max_length > 516) {
+        max_length = 516;
+    }
+    if (max_length < 3) {
+        return;
+    }
+    const uint8_t *input_ptr = &buf->input_data[input_index];
+    int min_match_index = input_index - buf->dictionary_size + 1;
+    int best_length = 2;
+    int chain_left = PK_FAST_MAX_CHAIN;
+    int match_index = buf->hash_head[pk_implode_hash(input_ptr)];
+    while (match_index != PK_NO_POSITION && match_index >= min_match_index && chain_left-- > 0) {
+        const uint8_t *match_ptr = &buf->input_data[match_index];
+        // best_length is always below max_length here, so this never reads past the data
+        if (match_ptr[best_length] == input_ptr[best_length] &&
+            match_ptr[0] == input_ptr[0] && match_ptr[1] == input_ptr[1]) {
+            int length = 2;
+            while (length < max_length && match_ptr[length] == input_ptr[length]) {
+                length++;
+            }
+            if (length > best_length) {
+                best_length = length;
+                copy->length = length;
+                copy->offset = (uint16_t) (input_index - match_index - 1);
+                if (length >= PK_FAST_NICE_LENGTH || length == max_length) {
+                    return;
+                }
+            }
+        }
+        match_index = buf->hash_prev[match_index];
+    }
+}
+
+static void pk_implode_find_copy(struct pk_comp_buffer *buf, int input_index, struct pk_copy_length_offset *copy)
+{
+    if (buf->level == ZIP_COMPRESSION_FAST) {
+        pk_implode_determine_copy_fast(buf, input_index, copy);
+    } else {
+        pk_implode_determine_copy(buf, input_index, copy);
+    }
+}
+
 static int pk_implode_next_copy_is_better(
     struct pk_comp_buffer *buf, int offset, const struct pk_copy_length_offset *current_copy)
 {
     struct pk_copy_length_offset next_copy;
-    pk_implode_determine_copy(buf, offset + 1, &next_copy);
+    pk_implode_find_copy(buf, offset + 1, &next_copy);
     if (current_copy->length >= next_copy.length) {
         return 0;
     }
@@ -390,6 +473,13 @@ static void pk_implode_data(struct pk_comp_buffer *buf)
 
     buf->current_output_bits_used = 0;
 
+    int lazy_limit = PK_BEST_LAZY_LIMIT;
+    if (buf->level == ZIP_COMPRESSION_FAST) {
+        lazy_limit = PK_FAST_LAZY_LIMIT;
+        memset(buf->hash_head, 0xff, sizeof(buf->hash_head)); // PK_NO_POSITION
+        buf->next_index_to_hash = input_ptr;
+    }
+
     while (!eof) {
         int bytes_read = pk_implode_fill_input_buffer(buf, 4096);
         if (bytes_read != 4096) {
@@ -403,24 +493,31 @@ static void pk_implode_data(struct pk_comp_buffer *buf)
             input_end += 516; // eat the 516 leftovers anyway
         }
 
+        buf->input_data_end = buf->dictionary_size + 516 + bytes_read;
+
+        int analyze_start;
         if (has_leftover_data == 0) {
-            pk_implode_analyze_input(buf, input_ptr, input_end + 1);
+            analyze_start = input_ptr;
             has_leftover_data++;
             if (buf->dictionary_size != 4096) {
                 has_leftover_data++;
             }
         } else if (has_leftover_data == 1) {
-            pk_implode_analyze_input(buf, input_ptr - buf->dictionary_size + 516, input_end + 1);
+            analyze_start = input_ptr - buf->dictionary_size + 516;
             has_leftover_data++;
-        } else if (has_leftover_data == 2) {
-            pk_implode_analyze_input(buf, input_ptr - buf->dictionary_size, input_end + 1);
+        } else {
+            analyze_start = input_ptr - buf->dictionary_size;
+        }
+        // the fast level fills its hash chains while looking for copies instead
+        if (buf->level != ZIP_COMPRESSION_FAST) {
+            pk_implode_analyze_input(buf, analyze_start, input_end + 1);
         }
 
         while (input_ptr < input_end) {
             int write_literal = 0;
             int write_copy = 0;
             struct pk_copy_length_offset copy;
-            pk_implode_determine_copy(buf, input_ptr, &copy);
+            pk_implode_find_copy(buf, input_ptr, &copy);
 
             if (copy.length == 0) {
                 write_literal = 1;
@@ -433,7 +530,7 @@ static void pk_implode_data(struct pk_comp_buffer *buf)
                 } else {
                     write_literal = 1;
                 }
-            } else if (copy.length >= 8 || input_ptr + 1 >= input_end) {
+            } else if (copy.length >= lazy_limit || input_ptr + 1 >= input_end) {
                 write_copy = 1;
             } else if (pk_implode_next_copy_is_better(buf, input_ptr, &copy)) {
                 write_literal = 1;
@@ -455,6 +552,9 @@ static void pk_implode_data(struct pk_comp_buffer *buf)
         if (!eof) {
             input_ptr -= 4096;
             pk_memcpy(buf->input_data, &buf->input_data[4096], buf->dictionary_size + 516);
+            if (buf->level == ZIP_COMPRESSION_FAST) {
+                pk_implode_slide_hash(buf, 4096);
+            }
         }
     }
 
@@ -467,8 +567,10 @@ static void pk_implode_data(struct pk_comp_buffer *buf)
 }
 
 static int pk_implode(pk_input_func *input_func, pk_output_func *output_func,
-                      struct pk_comp_buffer *buf, struct pk_token *token, int dictionary_size)
+                      struct pk_comp_buffer *buf, struct pk_token *token, int dictionary_size,
+                      zip_compression_level level)
 {
+    buf->level = level;
     buf->input_func = input_func;
     buf->output_func = output_func;
     buf->dictionary_size = dictionary_size;
@@ -521,162 +623,124 @@ static void pk_explode_construct_jump_table(int size, const uint8_t *bits, const
     }
 }
 
-static int pk_explode_set_bits_used(struct pk_decomp_buffer *buf, int num_bits)
+static void pk_explode_refill_bits(struct pk_bit_reader *reader)
 {
-    if (buf->current_input_bits_available >= num_bits) {
-        buf->current_input_bits_available -= num_bits;
-        buf->current_input_byte = (uint16_t) (buf->current_input_byte >> num_bits);
-        return 0;
-    }
-    buf->current_input_byte = (uint16_t) (buf->current_input_byte >> buf->current_input_bits_available);
-    if (buf->input_buffer_ptr == buf->input_buffer_end) {
-        // Fill buffer
-        buf->input_buffer_ptr = 2048;
-        buf->input_buffer_end = buf->input_func(buf->input_buffer, buf->input_buffer_ptr, buf->token);
-        if (!buf->input_buffer_end) {
-            return 1;
-        }
-        buf->input_buffer_ptr = 0;
+    // bytes past the end read as zero, pk_explode_has_overrun() tells whether they were used
+    while (reader->bits_available <= 56) {
+        uint64_t byte = reader->next_byte < reader->length ? reader->data[reader->next_byte] : 0;
+        reader->bits |= byte << reader->bits_available;
+        reader->bits_available += 8;
+        reader->next_byte++;
     }
-
-    buf->current_input_byte |= (uint16_t) (buf->input_buffer[buf->input_buffer_ptr++] << 8);
-    buf->current_input_byte = (uint16_t) (buf->current_input_byte >> (num_bits - buf->current_input_bits_available));
-    buf->current_input_bits_available += 8 - num_bits;
-    return 0;
 }
 
-static int pk_explode_decode_next_token(struct pk_decomp_buffer *buf)
+static unsigned int pk_explode_take_bits(struct pk_bit_reader *reader, int num_bits)
 {
-    if (buf->current_input_byte & 1) {
-        // copy
-        if (pk_explode_set_bits_used(buf, 1)) {
-            return PK_ERROR_VALUE;
-        }
-        int index = buf->copy_length_jump_table[buf->current_input_byte & 0xff];
-        if (pk_explode_set_bits_used(buf, pk_copy_length_base_bits[index])) {
-            return PK_ERROR_VALUE;
-        }
-        int extra_bits = pk_copy_length_extra_bits[index];
-        if (extra_bits) {
-            int extra_bits_value = buf->current_input_byte & ((1 << extra_bits) - 1);
-            if (pk_explode_set_bits_used(buf, extra_bits) && index + extra_bits_value != 270) {
-                return PK_ERROR_VALUE;
-            }
-            index = pk_copy_length_base_value[index] + extra_bits_value;
-        }
-        return index + 256;
-    } else {
-        // literal token
-        if (pk_explode_set_bits_used(buf, 1)) {
-            return PK_ERROR_VALUE;
-        }
-        int result = buf->current_input_byte & 0xff;
-        if (pk_explode_set_bits_used(buf, 8)) {
-            return PK_ERROR_VALUE;
-        }
-        return result;
-    }
+    unsigned int value = (unsigned int) (reader->bits & ((1u << num_bits) - 1));
+    reader->bits >>= num_bits;
+    reader->bits_available -= num_bits;
+    return value;
 }
 
-static int pk_explode_get_copy_offset(struct pk_decomp_buffer *buf, int copy_length)
+static int pk_explode_has_overrun(const struct pk_bit_reader *reader)
 {
-    int index = buf->copy_offset_jump_table[buf->current_input_byte & 0xff];
-    if (pk_explode_set_bits_used(buf, pk_copy_offset_bits[index])) {
-        return 0;
-    }
-    int offset;
-    if (copy_length == 2) {
-        offset = (buf->current_input_byte & 3) | (index << 2);
-        if (pk_explode_set_bits_used(buf, 2)) {
-            return 0;
-        }
-    } else {
-        offset = (buf->current_input_byte & buf->dictionary_size) | (index << buf->window_size);
-        if (pk_explode_set_bits_used(buf, buf->window_size)) {
-            return 0;
-        }
-    }
-    return offset + 1;
+    return reader->next_byte * 8 - reader->bits_available > reader->length * 8;
 }
 
-static int pk_explode_data(struct pk_decomp_buffer *buf)
+static void pk_explode_copy(uint8_t *output, uint8_t *dst, int distance, int length)
 {
-    int token;
-    buf->output_buffer_ptr = 4096;
-    while (1) {
-        token = pk_explode_decode_next_token(buf);
-        if (token >= PK_ERROR_VALUE - 1) {
-            break;
-        }
-        if (token >= 256) {
-            // copy offset
-            int length = token - 254;
-            int offset = pk_explode_get_copy_offset(buf, length);
-            if (!offset) {
-                token = PK_ERROR_VALUE;
-                break;
-            }
-            uint8_t *src = &buf->output_buffer[buf->output_buffer_ptr - offset];
-            uint8_t *dst = &buf->output_buffer[buf->output_buffer_ptr];
-            buf->output_buffer_ptr += length;
-            do {
-                *dst = *src;
-                src++;
-                dst++;
-            } while (--length > 0);
-        } else {
-            // literal byte
-            buf->output_buffer[buf->output_buffer_ptr++] = (uint8_t) token;
-        }
-        if (buf->output_buffer_ptr >= 8192) {
-            // Flush buffer
-            buf->output_func(&buf->output_buffer[4096], 4096, buf->token);
-            pk_memcpy(buf->output_buffer, &buf->output_buffer[4096], buf->output_buffer_ptr - 4096);
-            buf->output_buffer_ptr -= 4096;
-        }
+    uint8_t *src = dst - distance;
+    if (src < output) {
+        // the dictionary starts out as zeros
+        int zeros = (int) (output - src) < length ? (int) (output - src) : length;
+        memset(dst, 0, zeros);
+        dst += zeros;
+        src += zeros;
+        length -= zeros;
+    }
+    // an overlapping copy repeats the bytes between src and dst, so every step can copy twice as much
+    while (length > 0) {
+        int chunk = (int) (dst - src) < length ? (int) (dst - src) : length;
+        memcpy(dst, src, chunk);
+        dst += chunk;
+        length -= chunk;
     }
-    // Flush buffer
-    buf->output_func(&buf->output_buffer[4096], buf->output_buffer_ptr - 4096, buf->token);
-    return token;
 }
 
-static int pk_explode(pk_input_func *input_func, pk_output_func *output_func,
-                      struct pk_decomp_buffer *buf, struct pk_token *token)
+static int pk_explode(const uint8_t *input, int input_length, uint8_t *output, int *output_length)
 {
-    buf->input_func = input_func;
-    buf->output_func = output_func;
-    buf->token = token;
-    buf->input_buffer_ptr = 2048;
-    int bytes_read = buf->input_func(buf->input_buffer, buf->input_buffer_ptr, buf->token);
-    buf->input_buffer_end = bytes_read;
-    if (bytes_read <= 4) {
+    if (input_length <= 4) {
         return PK_TOO_FEW_INPUT_BYTES;
     }
-    int has_literal_encoding = buf->input_buffer[0];
-    buf->window_size = buf->input_buffer[1];
-    buf->current_input_byte = buf->input_buffer[2];
-    buf->current_input_bits_available = 0;
-    buf->input_buffer_ptr = 3;
-
-    if (buf->window_size < 4 || buf->window_size > 6) {
+    int has_literal_encoding = input[0];
+    int window_size = input[1];
+    if (window_size < 4 || window_size > 6) {
         return PK_INVALID_WINDOWSIZE;
     }
-
-    buf->dictionary_size = 0xFFFF >> (16 - buf->window_size);
     if (has_literal_encoding) {
         return PK_LITERAL_ENCODING_UNSUPPORTED;
     }
+    unsigned int offset_low_mask = 0xFFFF >> (16 - window_size);
 
-    // Decode data for copying bytes
-    pk_explode_construct_jump_table(16,
-        pk_copy_length_base_bits, pk_copy_length_base_code, buf->copy_length_jump_table);
-    pk_explode_construct_jump_table(64,
-        pk_copy_offset_bits, pk_copy_offset_code, buf->copy_offset_jump_table);
+    uint8_t copy_length_jump_table[256];
+    uint8_t copy_offset_jump_table[256];
+    pk_explode_construct_jump_table(16, pk_copy_length_base_bits, pk_copy_length_base_code, copy_length_jump_table);
+    pk_explode_construct_jump_table(64, pk_copy_offset_bits, pk_copy_offset_code, copy_offset_jump_table);
 
-    int result = pk_explode_data(buf);
-    if (result != PK_EOF) {
-        return PK_ERROR_DECODING;
+    struct pk_bit_reader reader = { input, input_length, 2, 0, 0 };
+    uint8_t *dst = output;
+    uint8_t *dst_end = output + *output_length;
+    while (1) {
+        // a token takes at most 30 bits, so there is no need to refill in the middle of one
+        if (reader.bits_available < 30) {
+            pk_explode_refill_bits(&reader);
+        }
+        if (!(reader.bits & 1)) {
+            pk_explode_take_bits(&reader, 1);
+            uint8_t literal = (uint8_t) pk_explode_take_bits(&reader, 8);
+            if (pk_explode_has_overrun(&reader)) {
+                return PK_ERROR_DECODING;
+            }
+            if (dst >= dst_end) {
+                log_error("COMP2 Out of buffer space.", 0, 0);
+                return PK_ERROR_DECODING;
+            }
+            *dst++ = literal;
+            continue;
+        }
+        pk_explode_take_bits(&reader, 1);
+        int index = copy_length_jump_table[reader.bits & 0xff];
+        pk_explode_take_bits(&reader, pk_copy_length_base_bits[index]);
+        int extra_bits = pk_copy_length_extra_bits[index];
+        if (extra_bits) {
+            index = pk_copy_length_base_value[index] + pk_explode_take_bits(&reader, extra_bits);
+        }
+        if (pk_explode_has_overrun(&reader)) {
+            return PK_ERROR_DECODING;
+        }
+        if (index + 256 == PK_EOF) {
+            break;
+        }
+        int length = index + 2;
+        int offset_index = copy_offset_jump_table[reader.bits & 0xff];
+        pk_explode_take_bits(&reader, pk_copy_offset_bits[offset_index]);
+        int offset;
+        if (length == 2) {
+            offset = pk_explode_take_bits(&reader, 2) | (offset_index << 2);
+        } else {
+            offset = (pk_explode_take_bits(&reader, window_size) & offset_low_mask) | (offset_index << window_size);
+        }
+        if (pk_explode_has_overrun(&reader)) {
+            return PK_ERROR_DECODING;
+        }
+        if (dst_end - dst < length) {
+            log_error("COMP2 Out of buffer space.", 0, 0);
+            return PK_ERROR_DECODING;
+        }
+        pk_explode_copy(output, dst, offset + 1, length);
+        dst += length;
     }
+    *output_length = (int) (dst - output);
     return PK_SUCCESS;
 }
 
@@ -718,7 +782,7 @@ static void zip_output_func(uint8_t *buffer, int length, struct pk_token *token)
 }
 
 int zip_compress(const void *input_buffer, int input_length,
-                 void *output_buffer, int *output_length)
+                 void *output_buffer, int *output_length, zip_compression_level level)
 {
     struct pk_token token;
     struct pk_comp_buffer *buf = (struct pk_comp_buffer *) malloc(sizeof(struct pk_comp_buffer));
@@ -735,7 +799,7 @@ int zip_compress(const void *input_buffer, int input_length,
     token.output_length = *output_length;
 
     int ok = 1;
-    int pk_error = pk_implode(zip_input_func, zip_output_func, buf, &token, 4096);
+    int pk_error = pk_implode(zip_input_func, zip_output_func, buf, &token, 4096, level);
     if (pk_error || token.stop) {
         log_error("COMP Error occurred while compressing.", 0, 0);
         ok = 0;
@@ -749,26 +813,9 @@ int zip_compress(const void *input_buffer, int input_length,
 int zip_decompress(const void *input_buffer, int input_length,
                    void *output_buffer, int *output_length)
 {
-    struct pk_token token;
-    struct pk_decomp_buffer *buf = (struct pk_decomp_buffer *) malloc(sizeof(struct pk_decomp_buffer));
-    if (!buf) {
-        return 0;
-    }
-    memset(buf, 0, sizeof(struct pk_decomp_buffer));
-    memset(&token, 0, sizeof(struct pk_token));
-    token.input_data = (const uint8_t *) input_buffer;
-    token.input_length = input_length;
-    token.output_data = (uint8_t *) output_buffer;
-    token.output_length = *output_length;
-
-    int ok = 1;
-    int pk_error = pk_explode(zip_input_func, zip_output_func, buf, &token);
-    if (pk_error || token.stop) {
+    if (pk_explode((const uint8_t *) input_buffer, input_length, (uint8_t *) output_buffer, output_length)) {
         log_error("COMP Error uncompressing.", 0, 0);
-        ok = 0;
-    } else {
-        *output_length = token.output_ptr;
+        return 0;
     }
-    free(buf);
-    return ok;
+    return 1;
 }
@@ -6,15 +6,22 @@
  * Compression functions.
  */
 
+typedef enum {
+    ZIP_COMPRESSION_BEST = 0, /**< Thorough search for copies, smallest output */
+    ZIP_COMPRESSION_FAST = 1 /**< Hash chain search with limits, much faster but slightly larger output */
+} zip_compression_level;
+
 /**
  * Compresses the input buffer.
  * @param input_buffer Input buffer to compress
  * @param input_length Length of input buffer
  * @param output_buffer Output buffer to write the compressed data to
  * @param output_length IN: available length of the output buffer, OUT: written bytes
+ * @param level Compression level, both levels can be decompressed by zip_decompress
  * @return boolean true on success, false on error
  */
-int zip_compress(const void *input_buffer, int input_length, void *output_buffer, int *output_length);
+int zip_compress(const void *input_buffer, int input_length, void *output_buffer, int *output_length,
+    zip_compression_level level);
 
 /**
  * Decompresses the input buffer
@@ -400,15 +400,15 @@ void empire_city_save_state(buffer *buf)
         buffer_write_u8(buf, city->is_sea_trade);
         buffer_write_u8(buf, 0);
         for (int f = 0; f < 3; f++) {
-            buffer_write_i16(buf, city->trader_figure_ids[f]);
+            buffer_write_i32(buf, city->trader_figure_ids[f]);
         }
-        for (int p = 0; p < 10; p++) {
+        for (int p = 0; p < 4; p++) {
             buffer_write_u8(buf, 0);
         }
     }
 }
 
-void empire_city_load_state(buffer *buf)
+void empire_city_load_state(buffer *buf, int expanded_ids)
 {
     for (int i = 0; i < MAX_CITIES; i++) {
         empire_city *city = &cities[i];
@@ -431,9 +431,16 @@ void empire_city_load_state(buffer *buf)
         city->empire_object_id = buffer_read_i16(buf);
         city->is_sea_trade = buffer_read_u8(buf);
         buffer_skip(buf, 1);
-        for (int f = 0; f < 3; f++) {
-            city->trader_figure_ids[f] = buffer_read_i16(buf);
+        if (expanded_ids) {
+            for (int f = 0; f < 3; f++) {
+                city->trader_figure_ids[f] = buffer_read_i32(buf);
+            }
+            buffer_skip(buf, 4);
+        } else {
+            for (int f = 0; f < 3; f++) {
+                city->trader_figure_ids[f] = buffer_read_i16(buf);
+            }
+            buffer_skip(buf, 10);
         }
-        buffer_skip(buf, 10);
     }
 }
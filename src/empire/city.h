@@ -71,6 +71,6 @@ int empire_unlock_all_resources(void);
 
 void empire_city_save_state(buffer *buf);
 
-void empire_city_load_state(buffer *buf);
+void empire_city_load_state(buffer *buf, int expanded_ids);
 
 #endif // EMPIRE_CITY_H
@@ -21,6 +21,7 @@
 #include "figuretype/wall.h"
 #include "figuretype/water.h"
 #include "figuretype/workcamp.h"
+#include "game/profiler.h"
 
 
 static void figure_nobody_action(figure *f)
@@ -124,22 +125,25 @@ void figure_action_handle(void)
 {
     city_figures_reset();
     city_entertainment_set_hippodrome_has_race(0);
-    for (int i = 1; i < figure_count(); i++) {
+    PROFILER_START(figures_timer);
+    for (int i = figure_next_in_use(0); i; i = figure_next_in_use(i)) {
         figure *f = figure_get(i);
-        if (f->state) {
-            if (f->targeted_by_figure_id) {
-                figure *attacker = figure_get(f->targeted_by_figure_id);
-                if (attacker->state != FIGURE_STATE_ALIVE) {
-                    f->targeted_by_figure_id = 0;
-                }
-                if (attacker->target_figure_id != i) {
-                    f->targeted_by_figure_id = 0;
-                }
+        PROFILER_START(figure_timer);
+        if (f->targeted_by_figure_id) {
+            figure *attacker = figure_get(f->targeted_by_figure_id);
+            if (attacker->state != FIGURE_STATE_ALIVE) {
+                f->targeted_by_figure_id = 0;
             }
-            figure_action_callbacks[f->type](f);
-            if (f->state == FIGURE_STATE_DEAD) {
-                figure_delete(f);
+            if (attacker->target_figure_id != i) {
+                f->targeted_by_figure_id = 0;
             }
         }
+        figure_action_callbacks[f->type](f);
+        PROFILER_ADD(PROFILER_SECTION_FIGURE_TYPE + f->type, figure_timer);
+        if (f->state == FIGURE_STATE_DEAD) {
+            figure_delete(f);
+        }
     }
+    PROFILER_STOP(PROFILER_SECTION_FIGURES, figures_timer);
+    PROFILER_COMMIT();
 }
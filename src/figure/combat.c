@@ -9,8 +9,13 @@
 #include "figure/sound.h"
 #include "game/difficulty.h"
 #include "map/figure.h"
+#include "map/grid.h"
 #include "sound/effect.h"
 
+#include <stdlib.h>
+
+#define MISSILE_CANDIDATES_SIZE_STEP 64
+
 static int is_attacking_native(const figure *f)
 {
     return f->type == FIGURE_INDIGENOUS_NATIVE && f->action_state == FIGURE_ACTION_159_NATIVE_ATTACKING;
@@ -149,124 +154,228 @@ void figure_combat_handle_attack(figure *f)
     }
 }
 
-int figure_combat_get_target_for_soldier(int x, int y, int max_distance)
+static struct {
+    int x;
+    int y;
+    int max_distance;
+    int attack_citizens;
+    int min_distance;
+    int min_figure_id;
+} search;
+
+static void start_search(int x, int y, int max_distance, int min_distance)
 {
-    int min_figure_id = 0;
-    int min_distance = 10000;
-    for (int i = 1; i < figure_count(); i++) {
-        figure *f = figure_get(i);
-        if (figure_is_dead(f)) {
-            continue;
-        }
-        if (figure_is_enemy(f) || f->type == FIGURE_RIOTER || is_attacking_native(f)) {
-            int distance = calc_maximum_distance(x, y, f->x, f->y);
-            if (distance <= max_distance) {
-                if (f->targeted_by_figure_id) {
-                    distance *= 2; // penalty
-                }
-                if (distance < min_distance) {
-                    min_distance = distance;
-                    min_figure_id = i;
-                }
-            }
-        }
+    search.x = x;
+    search.y = y;
+    search.max_distance = max_distance;
+    search.min_distance = min_distance;
+    search.min_figure_id = 0;
+}
+
+// figures are visited by area, so ties are broken on id to match the order of the figure list
+static int is_closer(int distance, int figure_id)
+{
+    return distance < search.min_distance ||
+        (distance == search.min_distance && search.min_figure_id && figure_id < search.min_figure_id);
+}
+
+static void set_closest(int distance, int figure_id)
+{
+    search.min_distance = distance;
+    search.min_figure_id = figure_id;
+}
+
+static void set_first(int figure_id)
+{
+    if (!search.min_figure_id || figure_id < search.min_figure_id) {
+        search.min_figure_id = figure_id;
     }
-    if (min_figure_id) {
-        return min_figure_id;
+}
+
+static int is_target_for_soldier(const figure *f)
+{
+    return !figure_is_dead(f) && (figure_is_enemy(f) || f->type == FIGURE_RIOTER || is_attacking_native(f));
+}
+
+static void find_target_for_soldier(figure *f)
+{
+    if (!is_target_for_soldier(f)) {
+        return;
     }
-    for (int i = 1; i < figure_count(); i++) {
-        figure *f = figure_get(i);
-        if (figure_is_dead(f)) {
-            continue;
+    int distance = calc_maximum_distance(search.x, search.y, f->x, f->y);
+    if (distance <= search.max_distance) {
+        if (f->targeted_by_figure_id) {
+            distance *= 2; // penalty
         }
-        if (figure_is_enemy(f) || f->type == FIGURE_RIOTER || is_attacking_native(f)) {
-            return i;
+        if (is_closer(distance, f->id)) {
+            set_closest(distance, f->id);
         }
     }
-    return 0;
 }
 
-int figure_combat_get_target_for_wolf(int x, int y, int max_distance)
+static void find_first_target_for_soldier(figure *f)
 {
-    int min_figure_id = 0;
-    int min_distance = 10000;
-    for (int i = 1; i < figure_count(); i++) {
-        figure *f = figure_get(i);
-        if (figure_is_dead(f) || !f->type) {
-            continue;
-        }
-        switch (f->type) {
-            case FIGURE_EXPLOSION:
-            case FIGURE_FORT_STANDARD:
-            case FIGURE_TRADE_SHIP:
-            case FIGURE_FISHING_BOAT:
-            case FIGURE_MAP_FLAG:
-            case FIGURE_FLOTSAM:
-            case FIGURE_SHIPWRECK:
-            case FIGURE_INDIGENOUS_NATIVE:
-            case FIGURE_TOWER_SENTRY:
-            case FIGURE_NATIVE_TRADER:
-            case FIGURE_ARROW:
-            case FIGURE_JAVELIN:
-            case FIGURE_BOLT:
-            case FIGURE_BALLISTA:
-            case FIGURE_FRIENDLY_ARROW:
-            case FIGURE_WATCHTOWER_ARCHER:
-            case FIGURE_CREATURE:
-                continue;
-        }
-        if (figure_is_enemy(f) || figure_is_herd(f)) {
-            continue;
-        }
-        if (figure_is_legion(f) && f->action_state == FIGURE_ACTION_80_SOLDIER_AT_REST) {
-            continue;
-        }
-        int distance = calc_maximum_distance(x, y, f->x, f->y);
-        if (f->targeted_by_figure_id) {
-            distance *= 2;
-        }
-        if (distance < min_distance) {
-            min_distance = distance;
-            min_figure_id = i;
-        }
+    if (is_target_for_soldier(f)) {
+        set_first(f->id);
+    }
+}
+
+int figure_combat_get_target_for_soldier(int x, int y, int max_distance)
+{
+    start_search(x, y, max_distance, 10000);
+    map_figure_foreach_in_area(x, y, max_distance, FIGURE_GROUP_HOSTILE, find_target_for_soldier);
+    if (search.min_figure_id) {
+        return search.min_figure_id;
+    }
+    start_search(x, y, GRID_SIZE, 10000);
+    map_figure_foreach_in_area(x, y, GRID_SIZE, FIGURE_GROUP_HOSTILE, find_first_target_for_soldier);
+    return search.min_figure_id;
+}
+
+static void find_target_for_wolf(figure *f)
+{
+    if (figure_is_dead(f) || !f->type) {
+        return;
+    }
+    switch (f->type) {
+        case FIGURE_EXPLOSION:
+        case FIGURE_FORT_STANDARD:
+        case FIGURE_TRADE_SHIP:
+        case FIGURE_FISHING_BOAT:
+        case FIGURE_MAP_FLAG:
+        case FIGURE_FLOTSAM:
+        case FIGURE_SHIPWRECK:
+        case FIGURE_INDIGENOUS_NATIVE:
+        case FIGURE_TOWER_SENTRY:
+        case FIGURE_NATIVE_TRADER:
+        case FIGURE_ARROW:
+        case FIGURE_JAVELIN:
+        case FIGURE_BOLT:
+        case FIGURE_BALLISTA:
+        case FIGURE_FRIENDLY_ARROW:
+        case FIGURE_WATCHTOWER_ARCHER:
+        case FIGURE_CREATURE:
+            return;
+    }
+    if (figure_is_enemy(f) || figure_is_herd(f)) {
+        return;
     }
-    if (min_distance <= max_distance && min_figure_id) {
-        return min_figure_id;
+    if (figure_is_legion(f) && f->action_state == FIGURE_ACTION_80_SOLDIER_AT_REST) {
+        return;
+    }
+    int distance = calc_maximum_distance(search.x, search.y, f->x, f->y);
+    if (f->targeted_by_figure_id) {
+        distance *= 2;
+    }
+    if (is_closer(distance, f->id)) {
+        set_closest(distance, f->id);
+    }
+}
+
+int figure_combat_get_target_for_wolf(int x, int y, int max_distance)
+{
+    // the doubled distance of a targeted figure is never smaller, so nothing outside the radius can qualify
+    start_search(x, y, max_distance, 10000);
+    map_figure_foreach_in_area(x, y, max_distance, FIGURE_GROUP_ALL & ~FIGURE_GROUP_HERD, find_target_for_wolf);
+    if (search.min_distance <= max_distance && search.min_figure_id) {
+        return search.min_figure_id;
     }
     return 0;
 }
 
-int figure_combat_get_target_for_enemy(int x, int y)
+static void find_target_for_enemy(figure *f)
 {
-    int min_figure_id = 0;
-    int min_distance = 10000;
-    for (int i = 1; i < figure_count(); i++) {
-        figure *f = figure_get(i);
-        if (figure_is_dead(f)) {
-            continue;
-        }
-        if (!f->targeted_by_figure_id && figure_is_legion(f)) {
-            int distance = calc_maximum_distance(x, y, f->x, f->y);
-            if (distance < min_distance) {
-                min_distance = distance;
-                min_figure_id = i;
-            }
+    if (figure_is_dead(f)) {
+        return;
+    }
+    if (!f->targeted_by_figure_id && figure_is_legion(f)) {
+        int distance = calc_maximum_distance(search.x, search.y, f->x, f->y);
+        if (is_closer(distance, f->id)) {
+            set_closest(distance, f->id);
         }
     }
-    if (min_figure_id) {
-        return min_figure_id;
+}
+
+static void find_first_target_for_enemy(figure *f)
+{
+    if (!figure_is_dead(f) && figure_is_legion(f)) {
+        set_first(f->id);
+    }
+}
+
+int figure_combat_get_target_for_enemy(int x, int y)
+{
+    start_search(x, y, GRID_SIZE, 10000);
+    map_figure_foreach_in_area(x, y, GRID_SIZE, FIGURE_GROUP_LEGION, find_target_for_enemy);
+    if (search.min_figure_id) {
+        return search.min_figure_id;
     }
     // no 'free' soldier found, take first one
-    for (int i = 1; i < figure_count(); i++) {
-        figure *f = figure_get(i);
-        if (figure_is_dead(f)) {
-            continue;
+    start_search(x, y, GRID_SIZE, 10000);
+    map_figure_foreach_in_area(x, y, GRID_SIZE, FIGURE_GROUP_LEGION, find_first_target_for_enemy);
+    return search.min_figure_id;
+}
+
+typedef struct {
+    int figure_id;
+    int distance;
+} missile_candidate;
+
+static struct {
+    missile_candidate *items;
+    int size;
+    int capacity;
+} missile_candidates;
+
+static void add_missile_candidate(const figure *f, int distance)
+{
+    if (distance >= search.max_distance) {
+        return;
+    }
+    if (missile_candidates.size >= missile_candidates.capacity) {
+        int capacity = missile_candidates.capacity ?
+            missile_candidates.capacity * 2 : MISSILE_CANDIDATES_SIZE_STEP;
+        missile_candidate *items = realloc(missile_candidates.items, sizeof(missile_candidate) * capacity);
+        if (!items) {
+            return;
         }
-        if (figure_is_legion(f)) {
-            return i;
+        missile_candidates.items = items;
+        missile_candidates.capacity = capacity;
+    }
+    missile_candidate *candidate = &missile_candidates.items[missile_candidates.size++];
+    candidate->figure_id = f->id;
+    candidate->distance = distance;
+}
+
+static int compare_missile_candidates(const void *a, const void *b)
+{
+    return ((const missile_candidate *) a)->figure_id - ((const missile_candidate *) b)->figure_id;
+}
+
+// the line of sight check leaves its state in figure 0, which is saved, so the candidates are
+// checked in the same order and with the same shrinking distance as a scan over the figure list
+static void find_missile_target(void)
+{
+    qsort(missile_candidates.items, missile_candidates.size, sizeof(missile_candidate),
+        compare_missile_candidates);
+    for (int i = 0; i < missile_candidates.size; i++) {
+        const missile_candidate *candidate = &missile_candidates.items[i];
+        figure *f = figure_get(candidate->figure_id);
+        if (candidate->distance < search.min_distance &&
+            figure_movement_can_launch_cross_country_missile(search.x, search.y, f->x, f->y)) {
+            set_closest(candidate->distance, candidate->figure_id);
         }
     }
-    return 0;
+}
+
+static void find_missile_target_for_soldier(figure *f)
+{
+    if (figure_is_dead(f)) {
+        return;
+    }
+    if (figure_is_enemy(f) || figure_is_herd(f) || is_attacking_native(f)) {
+        add_missile_candidate(f, calc_maximum_distance(search.x, search.y, f->x, f->y));
+    }
 }
 
 int figure_combat_get_missile_target_for_soldier(figure *shooter, int max_distance, map_point *tile)
@@ -274,77 +383,71 @@ int figure_combat_get_missile_target_for_soldier(figure *shooter, int max_distan
     int x = shooter->x;
     int y = shooter->y;
 
-    int min_distance = max_distance;
-    figure *min_figure = 0;
-    for (int i = 1; i < figure_count(); i++) {
-        figure *f = figure_get(i);
-        if (figure_is_dead(f)) {
-            continue;
-        }
-        if (figure_is_enemy(f) || figure_is_herd(f) || is_attacking_native(f)) {
-            int distance = calc_maximum_distance(x, y, f->x, f->y);
-            if (distance < min_distance && figure_movement_can_launch_cross_country_missile(x, y, f->x, f->y)) {
-                min_distance = distance;
-                min_figure = f;
-            }
-        }
-    }
-    if (min_figure) {
+    start_search(x, y, max_distance, max_distance);
+    missile_candidates.size = 0;
+    map_figure_foreach_in_area(x, y, max_distance, FIGURE_GROUP_HOSTILE | FIGURE_GROUP_HERD,
+        find_missile_target_for_soldier);
+    find_missile_target();
+    if (search.min_figure_id) {
+        figure *min_figure = figure_get(search.min_figure_id);
         map_point_store_result(min_figure->x, min_figure->y, tile);
         return min_figure->id;
     }
     return 0;
 }
 
+static void find_missile_target_for_enemy(figure *f)
+{
+    if (figure_is_dead(f) || !f->type) {
+        return;
+    }
+    switch (f->type) {
+        case FIGURE_EXPLOSION:
+        case FIGURE_FORT_STANDARD:
+        case FIGURE_MAP_FLAG:
+        case FIGURE_FLOTSAM:
+        case FIGURE_INDIGENOUS_NATIVE:
+        case FIGURE_NATIVE_TRADER:
+        case FIGURE_ARROW:
+        case FIGURE_JAVELIN:
+        case FIGURE_BOLT:
+        case FIGURE_BALLISTA:
+        case FIGURE_FRIENDLY_ARROW:
+        case FIGURE_WATCHTOWER_ARCHER:
+        case FIGURE_CREATURE:
+        case FIGURE_FISH_GULLS:
+        case FIGURE_SHIPWRECK:
+        case FIGURE_SHEEP:
+        case FIGURE_WOLF:
+        case FIGURE_ZEBRA:
+        case FIGURE_SPEAR:
+            return;
+    }
+    int distance;
+    if (figure_is_legion(f)) {
+        distance = calc_maximum_distance(search.x, search.y, f->x, f->y);
+    } else if (search.attack_citizens && f->is_friendly) {
+        distance = calc_maximum_distance(search.x, search.y, f->x, f->y) + 5;
+    } else {
+        return;
+    }
+    add_missile_candidate(f, distance);
+}
+
 int figure_combat_get_missile_target_for_enemy(figure *enemy, int max_distance, int attack_citizens,
                                                map_point *tile)
 {
     int x = enemy->x;
     int y = enemy->y;
 
-    figure *min_figure = 0;
-    int min_distance = max_distance;
-    for (int i = 1; i < figure_count(); i++) {
-        figure *f = figure_get(i);
-        if (figure_is_dead(f) || !f->type) {
-            continue;
-        }
-        switch (f->type) {
-            case FIGURE_EXPLOSION:
-            case FIGURE_FORT_STANDARD:
-            case FIGURE_MAP_FLAG:
-            case FIGURE_FLOTSAM:
-            case FIGURE_INDIGENOUS_NATIVE:
-            case FIGURE_NATIVE_TRADER:
-            case FIGURE_ARROW:
-            case FIGURE_JAVELIN:
-            case FIGURE_BOLT:
-            case FIGURE_BALLISTA:
-            case FIGURE_FRIENDLY_ARROW:
-            case FIGURE_WATCHTOWER_ARCHER:
-            case FIGURE_CREATURE:
-            case FIGURE_FISH_GULLS:
-            case FIGURE_SHIPWRECK:
-            case FIGURE_SHEEP:
-            case FIGURE_WOLF:
-            case FIGURE_ZEBRA:
-            case FIGURE_SPEAR:
-                continue;
-        }
-        int distance;
-        if (figure_is_legion(f)) {
-            distance = calc_maximum_distance(x, y, f->x, f->y);
-        } else if (attack_citizens && f->is_friendly) {
-            distance = calc_maximum_distance(x, y, f->x, f->y) + 5;
-        } else {
-            continue;
-        }
-        if (distance < min_distance && figure_movement_can_launch_cross_country_missile(x, y, f->x, f->y)) {
-            min_distance = distance;
-            min_figure = f;
-        }
-    }
-    if (min_figure) {
+    start_search(x, y, max_distance, max_distance);
+    search.attack_citizens = attack_citizens;
+    missile_candidates.size = 0;
+    map_figure_foreach_in_area(x, y, max_distance, FIGURE_GROUP_ALL & ~FIGURE_GROUP_HERD,
+        find_missile_target_for_enemy);
+    find_missile_target();
+    if (search.min_figure_id) {
+        figure *min_figure = figure_get(search.min_figure_id);
         map_point_store_result(min_figure->x, min_figure->y, tile);
         return min_figure->id;
     }
@@ -12,16 +12,73 @@
 #include "map/figure.h"
 #include "map/grid.h"
 
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
 #define FIGURE_ARRAY_SIZE_STEP 1000
 
 #define FIGURE_ORIGINAL_BUFFER_SIZE 128
-#define FIGURE_CURRENT_BUFFER_SIZE 128
+#define FIGURE_EXPANDED_IDS_BUFFER_SIZE 172
+#define FIGURE_CURRENT_BUFFER_SIZE 172
 
 static struct {
     int created_sequence;
     array(figure) figures;
 } data;
 
+static struct {
+    int is_valid;
+    uint32_t *words;
+    int capacity;
+} in_use;
+
+static int grow_in_use(int id)
+{
+    int needed = id / 32 + 1;
+    if (needed <= in_use.capacity) {
+        return 1;
+    }
+    int capacity = in_use.capacity ? in_use.capacity : FIGURE_ARRAY_SIZE_STEP / 32;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    uint32_t *words = realloc(in_use.words, sizeof(uint32_t) * capacity);
+    if (!words) {
+        in_use.is_valid = 0;
+        return 0;
+    }
+    memset(&words[in_use.capacity], 0, sizeof(uint32_t) * (capacity - in_use.capacity));
+    in_use.words = words;
+    in_use.capacity = capacity;
+    return 1;
+}
+
+static void set_in_use(int id, int is_in_use)
+{
+    if (!in_use.is_valid || !grow_in_use(id)) {
+        return;
+    }
+    if (is_in_use) {
+        in_use.words[id / 32] |= 1u << (id % 32);
+    } else {
+        in_use.words[id / 32] &= ~(1u << (id % 32));
+    }
+}
+
+static void rebuild_in_use(void)
+{
+    if (in_use.words) {
+        memset(in_use.words, 0, sizeof(uint32_t) * in_use.capacity);
+    }
+    in_use.is_valid = 1;
+    for (int i = 1; i < data.figures.size && in_use.is_valid; i++) {
+        if (figure_get(i)->state) {
+            set_in_use(i, 1);
+        }
+    }
+}
+
 figure *figure_get(int id)
 {
     return array_item(data.figures, id);
@@ -32,6 +89,31 @@ int figure_count(void)
     return data.figures.size;
 }
 
+int figure_next_in_use(int id)
+{
+    int size = data.figures.size;
+    if (!in_use.is_valid) {
+        for (id++; id < size; id++) {
+            if (figure_get(id)->state) {
+                return id;
+            }
+        }
+        return 0;
+    }
+    id++;
+    for (int word = id >> 5; word < in_use.capacity && id < size; word++, id = word << 5) {
+        uint32_t bits = in_use.words[word] >> (id & 31);
+        while (bits) {
+            if (bits & 1) {
+                return id < size ? id : 0;
+            }
+            bits >>= 1;
+            id++;
+        }
+    }
+    return 0;
+}
+
 figure *figure_create(figure_type type, int x, int y, direction_type dir)
 {
     figure *f = 0;
@@ -41,6 +123,7 @@ figure *figure_create(figure_type type, int x, int y, direction_type dir)
     }
 
     f->state = FIGURE_STATE_ALIVE;
+    set_in_use(f->id, 1);
     f->faction_id = 1;
     f->type = type;
     f->use_cross_country = 0;
@@ -176,6 +259,7 @@ void figure_delete(figure *f)
     int figure_id = f->id;
     memset(f, 0, sizeof(figure));
     f->id = figure_id;
+    set_in_use(figure_id, 0);
 
     array_trim(data.figures);
 }
@@ -217,6 +301,7 @@ void figure_init_scenario(void)
         log_error("Unable to create figures array. The game will now crash.", 0, 0);
     }
     data.created_sequence = 0;
+    rebuild_in_use();
 }
 
 void figure_kill_all(void)
@@ -224,6 +309,10 @@ void figure_kill_all(void)
     figure *f;
     array_foreach(data.figures, f)
     {
+        if (!f->state) {
+            // free slots are not in use: marking them dead would hide them from the action loop
+            continue;
+        }
         switch (f->type) {
             default:
                 f->state = FIGURE_STATE_DEAD;
@@ -348,6 +437,19 @@ static void figure_save(buffer *buf, const figure *f)
     buffer_write_i16(buf, f->attacker_id1);
     buffer_write_i16(buf, f->attacker_id2);
     buffer_write_i16(buf, f->opponent_id);
+
+    // Full figure, building and path ids. The 16 bit fields above only hold ids up to 32767
+    buffer_write_i32(buf, f->next_figure_id_on_same_tile);
+    buffer_write_i32(buf, f->routing_path_id);
+    buffer_write_i32(buf, f->building_id);
+    buffer_write_i32(buf, f->immigrant_building_id);
+    buffer_write_i32(buf, f->destination_building_id);
+    buffer_write_i32(buf, f->leading_figure_id);
+    buffer_write_i32(buf, f->target_figure_id);
+    buffer_write_i32(buf, f->targeted_by_figure_id);
+    buffer_write_i32(buf, f->attacker_id1);
+    buffer_write_i32(buf, f->attacker_id2);
+    buffer_write_i32(buf, f->opponent_id);
 }
 
 static void figure_load(buffer *buf, figure *f, int figure_buf_size)
@@ -449,6 +551,20 @@ static void figure_load(buffer *buf, figure *f, int figure_buf_size)
     f->attacker_id2 = buffer_read_i16(buf);
     f->opponent_id = buffer_read_i16(buf);
 
+    if (figure_buf_size >= FIGURE_EXPANDED_IDS_BUFFER_SIZE) {
+        f->next_figure_id_on_same_tile = buffer_read_i32(buf);
+        f->routing_path_id = buffer_read_i32(buf);
+        f->building_id = buffer_read_i32(buf);
+        f->immigrant_building_id = buffer_read_i32(buf);
+        f->destination_building_id = buffer_read_i32(buf);
+        f->leading_figure_id = buffer_read_i32(buf);
+        f->target_figure_id = buffer_read_i32(buf);
+        f->targeted_by_figure_id = buffer_read_i32(buf);
+        f->attacker_id1 = buffer_read_i32(buf);
+        f->attacker_id2 = buffer_read_i32(buf);
+        f->opponent_id = buffer_read_i32(buf);
+    }
+
     // The following code should only be executed if the savegame includes figure information that is not 
     // supported on this specific version of Augustus. The extra bytes in the buffer must be skipped in order
     // to prevent reading bogus data for the next figure
@@ -502,4 +618,5 @@ void figure_load_state(buffer *list, buffer *seq, int includes_figure_size)
         }
     }
     data.figures.size = highest_id_in_use + 1;
+    rebuild_in_use();
 }
@@ -16,7 +16,11 @@ typedef struct {
 
     unsigned char alternative_location_index;
     unsigned char flotsam_visible;
-    short next_figure_id_on_same_tile;
+    int next_figure_id_on_same_tile;
+    int next_figure_id_in_area;
+    int previous_figure_id_in_area;
+    short area_index; // 0 = not in the area index, otherwise area + 1
+    unsigned char area_group;
     unsigned char type;
     unsigned char resource_id;
     unsigned char use_cross_country;
@@ -51,7 +55,7 @@ typedef struct {
     short wait_ticks;
     unsigned char action_state;
     unsigned char progress_on_tile;
-    short routing_path_id;
+    int routing_path_id;
     short routing_path_current_tile;
     short routing_path_length;
     unsigned char in_building_wait_ticks;
@@ -71,9 +75,9 @@ typedef struct {
     short cc_delta_xy;
     unsigned char cc_direction; // 1 = x, 2 = y
     unsigned char speed_multiplier;
-    short building_id;
-    short immigrant_building_id;
-    short destination_building_id;
+    int building_id;
+    int immigrant_building_id;
+    int destination_building_id;
     short formation_id;
     unsigned char index_in_formation;
     unsigned char formation_at_rest;
@@ -81,7 +85,7 @@ typedef struct {
     unsigned char is_ghost;
     unsigned char min_max_seen;
     char progress_to_next_tick;
-    short leading_figure_id;
+    int leading_figure_id;
     unsigned char attack_image_offset;
     unsigned char wait_ticks_missile;
     signed char x_offset_cart;
@@ -103,15 +107,15 @@ typedef struct {
     unsigned char trader_id;
     unsigned char wait_ticks_next_target;
     unsigned char dont_draw_elevated;
-    short target_figure_id;
-    short targeted_by_figure_id;
+    int target_figure_id;
+    int targeted_by_figure_id;
     unsigned short created_sequence;
     unsigned short target_figure_created_sequence;
     unsigned char figures_on_same_tile_index;
     unsigned char num_attackers;
-    short attacker_id1;
-    short attacker_id2;
-    short opponent_id;
+    int attacker_id1;
+    int attacker_id2;
+    int opponent_id;
     struct {
         unsigned short tourist_money_spent;
         unsigned short ticks_since_last_visited_id[12];
@@ -124,6 +128,13 @@ figure *figure_get(int id);
 
 int figure_count(void);
 
+/**
+ * Gets the next figure slot that is in use, in ascending id order
+ * @param id Id to start after, 0 to get the first figure
+ * @return Id of the next figure in use, or 0 when there are no more figures
+ */
+int figure_next_in_use(int id);
+
 /**
  * Creates a figure
  * @param type Figure type
@@ -19,7 +19,8 @@
 
 #define FORMATION_ARRAY_SIZE_STEP 50
 #define ORIGINAL_BUFFER_SIZE_PER_FORMATION 128
-#define CURRENT_BUFFER_SIZE_PER_FORMATION 128
+#define EXPANDED_IDS_BUFFER_SIZE_PER_FORMATION 204
+#define CURRENT_BUFFER_SIZE_PER_FORMATION 204
 
 static array(formation) formations;
 
@@ -554,7 +555,7 @@ void formation_move_herds_away(int x, int y)
 void formation_calculate_figures(void)
 {
     clear_figures();
-    for (int i = 1; i < figure_count(); i++) {
+    for (int i = figure_next_in_use(0); i; i = figure_next_in_use(i)) {
         figure *f = figure_get(i);
         if (f->state != FIGURE_STATE_ALIVE) {
             continue;
@@ -756,6 +757,14 @@ void formations_save_state(buffer *buf, buffer *totals)
         buffer_write_u8(buf, f->herd_direction);
         buffer_skip(buf, 17);
         buffer_write_i16(buf, f->invasion_sequence);
+
+        // Full ids, the 16 bit fields above only hold ids up to 32767
+        buffer_write_i32(buf, f->building_id);
+        for (int fig = 0; fig < MAX_FORMATION_FIGURES; fig++) {
+            buffer_write_i32(buf, f->figures[fig]);
+        }
+        buffer_write_i32(buf, f->destination_building_id);
+        buffer_write_i32(buf, f->standard_figure_id);
     }
     buffer_write_i32(totals, data.id_last_in_use);
     buffer_write_i32(totals, data.id_last_legion);
@@ -849,6 +858,15 @@ void formations_load_state(buffer *buf, buffer *totals, int includes_buffer_size
         buffer_skip(buf, 17);
         f->invasion_sequence = buffer_read_i16(buf);
 
+        if (formation_buf_size >= EXPANDED_IDS_BUFFER_SIZE_PER_FORMATION) {
+            f->building_id = buffer_read_i32(buf);
+            for (int fig = 0; fig < MAX_FORMATION_FIGURES; fig++) {
+                f->figures[fig] = buffer_read_i32(buf);
+            }
+            f->destination_building_id = buffer_read_i32(buf);
+            f->standard_figure_id = buffer_read_i32(buf);
+        }
+
         if (formation_buf_size > CURRENT_BUFFER_SIZE_PER_FORMATION) {
             buffer_skip(buf, formation_buf_size - CURRENT_BUFFER_SIZE_PER_FORMATION);
         }
@@ -383,7 +383,7 @@ void formation_legion_update(void)
 
 void formation_legion_decrease_damage(void)
 {
-    for (int i = 1; i < figure_count(); i++) {
+    for (int i = figure_next_in_use(0); i; i = figure_next_in_use(i)) {
         figure *f = figure_get(i);
         if (f->state == FIGURE_STATE_ALIVE && figure_is_legion(f)) {
             if (f->action_state == FIGURE_ACTION_80_SOLDIER_AT_REST) {
@@ -1,21 +1,38 @@
 #include "route.h"
 
 #include "core/array.h"
+#include "core/config.h"
 #include "core/log.h"
 #include "map/routing.h"
 #include "map/routing_path.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 #define ARRAY_SIZE_STEP 600
-#define MAX_PATH_LENGTH 500
+#define POOL_SIZE_STEP 65536
+#define BITS_PER_DIRECTION 3
+#define DIRECTION_MASK 0x7
+#define ORIGINAL_PATH_LENGTH 500
 
 typedef struct {
     int id;
     int figure_id;
-    uint8_t directions[MAX_PATH_LENGTH];
+    int offset;
+    int length;
 } figure_path_data;
 
 static array(figure_path_data) paths;
 
+// Directions of all paths, packed at three bits each
+static struct {
+    uint8_t *data;
+    int size;
+    int capacity;
+} pool;
+
+static uint8_t directions[MAX_ROUTING_PATH_LENGTH];
+
 static void create_new_path(figure_path_data *path, int position)
 {
     path->id = position;
@@ -26,10 +43,93 @@ static int path_is_used(const figure_path_data *path)
     return path->figure_id != 0;
 }
 
+static int packed_size(int length)
+{
+    return (length * BITS_PER_DIRECTION + 7) / 8;
+}
+
+static void clear_pool(void)
+{
+    free(pool.data);
+    pool.data = 0;
+    pool.size = 0;
+    pool.capacity = 0;
+}
+
+static int reserve_pool(int needed)
+{
+    if (pool.size + needed <= pool.capacity) {
+        return 1;
+    }
+    // move the directions of used paths to a new pool, dropping those of removed paths
+    int used = 0;
+    figure_path_data *path;
+    array_foreach(paths, path)
+    {
+        if (path_is_used(path)) {
+            used += packed_size(path->length) + 1;
+        }
+    }
+    int capacity = 2 * (used + needed);
+    if (capacity < POOL_SIZE_STEP) {
+        capacity = POOL_SIZE_STEP;
+    }
+    uint8_t *data = malloc(capacity);
+    if (!data) {
+        return 0;
+    }
+    int size = 0;
+    array_foreach(paths, path)
+    {
+        if (path_is_used(path)) {
+            // one extra byte so a direction can always be read as two bytes
+            int bytes = packed_size(path->length) + 1;
+            memcpy(&data[size], &pool.data[path->offset], bytes);
+            path->offset = size;
+            size += bytes;
+        }
+    }
+    free(pool.data);
+    pool.data = data;
+    pool.size = size;
+    pool.capacity = capacity;
+    return 1;
+}
+
+static uint8_t *allocate_directions(figure_path_data *path, int length)
+{
+    int bytes = packed_size(length) + 1;
+    if (!reserve_pool(bytes)) {
+        return 0;
+    }
+    path->offset = pool.size;
+    path->length = length;
+    pool.size += bytes;
+    uint8_t *data = &pool.data[path->offset];
+    memset(data, 0, bytes);
+    return data;
+}
+
+static int store_directions(figure_path_data *path, const uint8_t *path_directions, int length)
+{
+    uint8_t *data = allocate_directions(path, length);
+    if (!data) {
+        return 0;
+    }
+    for (int i = 0; i < length; i++) {
+        int bit = i * BITS_PER_DIRECTION;
+        int value = (path_directions[i] & DIRECTION_MASK) << (bit & 7);
+        data[bit >> 3] |= value & 0xff;
+        data[(bit >> 3) + 1] |= value >> 8;
+    }
+    return 1;
+}
+
 void figure_route_clear_all(void)
 {
     paths.size = 0;
     array_trim(paths);
+    clear_pool();
 }
 
 void figure_route_clean(void)
@@ -48,6 +148,78 @@ void figure_route_clean(void)
     array_trim(paths);
 }
 
+static int get_land_path(const figure *f, uint8_t *directions, int direction_limit)
+{
+    int can_travel;
+    int hierarchical = config_get(CONFIG_GP_CH_HIERARCHICAL_ROUTING);
+    switch (f->terrain_usage) {
+        case TERRAIN_USAGE_ENEMY:
+            can_travel = map_routing_noncitizen_can_travel_over_land(f->x, f->y,
+                f->destination_x, f->destination_y, f->destination_building_id, 5000);
+            if (!can_travel) {
+                if (hierarchical) {
+                    can_travel = map_routing_noncitizen_can_travel_over_land_hierarchical(f->x, f->y,
+                        f->destination_x, f->destination_y, 25000);
+                } else {
+                    can_travel = map_routing_noncitizen_can_travel_over_land(f->x, f->y,
+                        f->destination_x, f->destination_y, 0, 25000);
+                }
+                if (!can_travel) {
+                    can_travel = map_routing_noncitizen_can_travel_through_everything(
+                        f->x, f->y, f->destination_x, f->destination_y);
+                }
+            }
+            break;
+        case TERRAIN_USAGE_WALLS:
+            if (hierarchical) {
+                can_travel = map_routing_can_travel_over_walls_hierarchical(f->x, f->y,
+                    f->destination_x, f->destination_y);
+            } else {
+                can_travel = map_routing_can_travel_over_walls(f->x, f->y,
+                    f->destination_x, f->destination_y);
+            }
+            break;
+        case TERRAIN_USAGE_ANIMAL:
+            can_travel = map_routing_noncitizen_can_travel_over_land(f->x, f->y,
+                f->destination_x, f->destination_y, -1, 5000);
+            break;
+        case TERRAIN_USAGE_PREFER_ROADS:
+            can_travel = map_routing_citizen_can_travel_over_road_garden(f->x, f->y,
+                f->destination_x, f->destination_y);
+            if (!can_travel) {
+                if (hierarchical) {
+                    can_travel = map_routing_citizen_can_travel_over_land_hierarchical(f->x, f->y,
+                        f->destination_x, f->destination_y);
+                } else {
+                    can_travel = map_routing_citizen_can_travel_over_land(f->x, f->y,
+                        f->destination_x, f->destination_y);
+                }
+            }
+            break;
+        case TERRAIN_USAGE_ROADS:
+            can_travel = map_routing_citizen_can_travel_over_road_garden(f->x, f->y,
+                f->destination_x, f->destination_y);
+            break;
+        default:
+            can_travel = map_routing_citizen_can_travel_over_land(f->x, f->y,
+                f->destination_x, f->destination_y);
+            break;
+    }
+    if (can_travel) {
+        if (f->terrain_usage == TERRAIN_USAGE_WALLS) {
+            int path_length = map_routing_get_path(directions, f->x, f->y,
+                f->destination_x, f->destination_y, 4);
+            if (path_length > 0) {
+                return path_length;
+            }
+        }
+        return map_routing_get_path(directions, f->x, f->y,
+            f->destination_x, f->destination_y, direction_limit);
+    } else { // cannot travel
+        return 0;
+    }
+}
+
 void figure_route_add(figure *f)
 {
     f->routing_path_id = 0;
@@ -70,71 +242,18 @@ void figure_route_add(figure *f)
     if (f->is_boat) {
         if (f->is_boat == 2) { // flotsam
             map_routing_calculate_distances_water_flotsam(f->x, f->y);
-            path_length = map_routing_get_path_on_water(path->directions,
+            path_length = map_routing_get_path_on_water(directions,
                 f->destination_x, f->destination_y, 1);
         } else {
             map_routing_calculate_distances_water_boat(f->x, f->y);
-            path_length = map_routing_get_path_on_water(path->directions,
+            path_length = map_routing_get_path_on_water(directions,
                 f->destination_x, f->destination_y, 0);
         }
     } else {
         // land figure
-        int can_travel;
-        switch (f->terrain_usage) {
-            case TERRAIN_USAGE_ENEMY:
-                can_travel = map_routing_noncitizen_can_travel_over_land(f->x, f->y,
-                    f->destination_x, f->destination_y, f->destination_building_id, 5000);
-                if (!can_travel) {
-                    can_travel = map_routing_noncitizen_can_travel_over_land(f->x, f->y,
-                        f->destination_x, f->destination_y, 0, 25000);
-                    if (!can_travel) {
-                        can_travel = map_routing_noncitizen_can_travel_through_everything(
-                            f->x, f->y, f->destination_x, f->destination_y);
-                    }
-                }
-                break;
-            case TERRAIN_USAGE_WALLS:
-                can_travel = map_routing_can_travel_over_walls(f->x, f->y,
-                    f->destination_x, f->destination_y);
-                break;
-            case TERRAIN_USAGE_ANIMAL:
-                can_travel = map_routing_noncitizen_can_travel_over_land(f->x, f->y,
-                    f->destination_x, f->destination_y, -1, 5000);
-                break;
-            case TERRAIN_USAGE_PREFER_ROADS:
-                can_travel = map_routing_citizen_can_travel_over_road_garden(f->x, f->y,
-                    f->destination_x, f->destination_y);
-                if (!can_travel) {
-                    can_travel = map_routing_citizen_can_travel_over_land(f->x, f->y,
-                        f->destination_x, f->destination_y);
-                }
-                break;
-            case TERRAIN_USAGE_ROADS:
-                can_travel = map_routing_citizen_can_travel_over_road_garden(f->x, f->y,
-                    f->destination_x, f->destination_y);
-                break;
-            default:
-                can_travel = map_routing_citizen_can_travel_over_land(f->x, f->y,
-                    f->destination_x, f->destination_y);
-                break;
-        }
-        if (can_travel) {
-            if (f->terrain_usage == TERRAIN_USAGE_WALLS) {
-                path_length = map_routing_get_path(path->directions, f->x, f->y,
-                    f->destination_x, f->destination_y, 4);
-                if (path_length <= 0) {
-                    path_length = map_routing_get_path(path->directions, f->x, f->y,
-                        f->destination_x, f->destination_y, direction_limit);
-                }
-            } else {
-                path_length = map_routing_get_path(path->directions, f->x, f->y,
-                    f->destination_x, f->destination_y, direction_limit);
-            }
-        } else { // cannot travel
-            path_length = 0;
-        }
+        path_length = get_land_path(f, directions, direction_limit);
     }
-    if (path_length) {
+    if (path_length && store_directions(path, directions, path_length)) {
         path->figure_id = f->id;
         f->routing_path_id = path->id;
         f->routing_path_length = path_length;
@@ -154,46 +273,114 @@ void figure_route_remove(figure *f)
 
 int figure_route_get_direction(int path_id, int index)
 {
-    return array_item(paths, path_id)->directions[index];
+    const figure_path_data *path = array_item(paths, path_id);
+    int bit = index * BITS_PER_DIRECTION;
+    const uint8_t *data = &pool.data[path->offset + (bit >> 3)];
+    return ((data[0] | (data[1] << 8)) >> (bit & 7)) & DIRECTION_MASK;
 }
 
 void figure_route_save_state(buffer *figures, buffer *buf_paths)
 {
-    int size = paths.size * sizeof(int);
+    int size = paths.size * 2 * sizeof(int32_t);
     uint8_t *buf_data = malloc(size);
     buffer_init(figures, buf_data, size);
 
-    size = paths.size * sizeof(uint8_t) * MAX_PATH_LENGTH;
+    size = 0;
+    figure_path_data *path;
+    array_foreach(paths, path)
+    {
+        if (path_is_used(path)) {
+            size += packed_size(path->length);
+        }
+    }
     buf_data = malloc(size);
     buffer_init(buf_paths, buf_data, size);
 
-    figure_path_data *path;
     array_foreach(paths, path)
     {
-        buffer_write_i16(figures, path->figure_id);
-        buffer_write_raw(buf_paths, path->directions, MAX_PATH_LENGTH);
+        int length = path_is_used(path) ? path->length : 0;
+        buffer_write_i32(figures, path->figure_id);
+        buffer_write_i32(figures, length);
+        if (length) {
+            buffer_write_raw(buf_paths, &pool.data[path->offset], packed_size(length));
+        }
     }
 }
 
-void figure_route_load_state(buffer *figures, buffer *buf_paths)
+static int original_path_length(int path_id, int figure_id)
 {
-    int elements_to_load = buf_paths->size / MAX_PATH_LENGTH;
-
-    if (!array_init(paths, ARRAY_SIZE_STEP, create_new_path, path_is_used) ||
-        !array_expand(paths, elements_to_load)) {
-        log_error("Unable to create paths array. The game will likely crash.", 0, 0);
-        return;
+    if (figure_id <= 0 || figure_id >= figure_count()) {
+        return 0;
     }
+    const figure *f = figure_get(figure_id);
+    if (f->routing_path_id != path_id || f->routing_path_length <= 0) {
+        return 0;
+    }
+    return f->routing_path_length < ORIGINAL_PATH_LENGTH ? f->routing_path_length : ORIGINAL_PATH_LENGTH;
+}
 
+static int load_original_paths(buffer *figures, buffer *buf_paths, int expanded_ids)
+{
+    int elements_to_load = buf_paths->size / ORIGINAL_PATH_LENGTH;
+    if (!array_expand(paths, elements_to_load)) {
+        return -1;
+    }
     int highest_id_in_use = 0;
+    for (int i = 0; i < elements_to_load; i++) {
+        figure_path_data *path = array_next(paths);
+        int figure_id = expanded_ids ? buffer_read_i32(figures) : buffer_read_i16(figures);
+        buffer_read_raw(buf_paths, directions, ORIGINAL_PATH_LENGTH);
+        // the original format does not store the path length, so take it from the figure using the path
+        if (!store_directions(path, directions, original_path_length(i, figure_id))) {
+            return -1;
+        }
+        path->figure_id = figure_id;
+        if (path->figure_id) {
+            highest_id_in_use = i;
+        }
+    }
+    return highest_id_in_use;
+}
 
+static int load_packed_paths(buffer *figures, buffer *buf_paths)
+{
+    int elements_to_load = figures->size / (2 * sizeof(int32_t));
+    if (!array_expand(paths, elements_to_load)) {
+        return -1;
+    }
+    int highest_id_in_use = 0;
     for (int i = 0; i < elements_to_load; i++) {
         figure_path_data *path = array_next(paths);
-        path->figure_id = buffer_read_i16(figures);
-        buffer_read_raw(buf_paths, path->directions, MAX_PATH_LENGTH);
+        int figure_id = buffer_read_i32(figures);
+        int length = buffer_read_i32(figures);
+        if (length < 0 || length > MAX_ROUTING_PATH_LENGTH) {
+            length = 0;
+        }
+        uint8_t *data = allocate_directions(path, length);
+        if (!data) {
+            return -1;
+        }
+        buffer_read_raw(buf_paths, data, packed_size(length));
+        path->figure_id = figure_id;
         if (path->figure_id) {
             highest_id_in_use = i;
         }
     }
+    return highest_id_in_use;
+}
+
+void figure_route_load_state(buffer *figures, buffer *buf_paths, int expanded_ids, int packed_paths)
+{
+    clear_pool();
+    if (!array_init(paths, ARRAY_SIZE_STEP, create_new_path, path_is_used)) {
+        log_error("Unable to create paths array. The game will likely crash.", 0, 0);
+        return;
+    }
+    int highest_id_in_use = packed_paths ?
+        load_packed_paths(figures, buf_paths) : load_original_paths(figures, buf_paths, expanded_ids);
+    if (highest_id_in_use < 0) {
+        log_error("Unable to load paths. The game will likely crash.", 0, 0);
+        return;
+    }
     paths.size = highest_id_in_use + 1;
 }
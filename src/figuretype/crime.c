@@ -26,6 +26,7 @@
 #include "game/tutorial.h"
 #include "game/resource.h"
 #include "map/building.h"
+#include "map/figure.h"
 #include "map/grid.h"
 #include "map/road_access.h"
 #include "scenario/property.h"
@@ -368,6 +369,7 @@ void figure_rioter_action(figure *f)
                     figure_route_remove(f);
                 } else {
                     f->type = FIGURE_CRIMINAL;
+                    map_figure_update_group(f);
                     f->action_state = FIGURE_ACTION_120_RIOTER_CREATED;
                     figure_route_remove(f);
                 }
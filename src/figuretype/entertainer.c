@@ -13,6 +13,7 @@
 #include "figure/image.h"
 #include "figure/movement.h"
 #include "figure/route.h"
+#include "map/figure.h"
 #include "map/grid.h"
 #include "map/road_access.h"
 #include "map/road_network.h"
@@ -39,8 +40,8 @@ static int determine_tourist_destination(int x, int y)
 
     building_list_large_clear();
 
-    for (int i = 1; i < building_count(); i++) {
-        building *b = building_get(i);
+    for (building *b = building_first_in_category(BUILDING_CATEGORY_CULTURE); b;
+         b = building_next_in_category(BUILDING_CATEGORY_CULTURE, b)) {
         if (b->state != BUILDING_STATE_IN_USE) {
             continue;
         }
@@ -54,7 +55,7 @@ static int determine_tourist_destination(int x, int y)
             if (b->type == BUILDING_HIPPODROME && b->prev_part_building_id) {
                 continue;
             }
-            building_list_large_add(i);
+            building_list_large_add(b->id);
         }
     }
     int total_venues = building_list_large_size();
@@ -254,7 +255,7 @@ static int get_nearest_enemy(int x, int y, int *distance)
 {
     int min_enemy_id = 0;
     int min_dist = INFINITE;
-    for (int i = 1; i < figure_count(); i++) {
+    for (int i = figure_next_in_use(0); i; i = figure_next_in_use(i)) {
         figure *f = figure_get(i);
         if (figure_is_dead(f)) {
             continue;
@@ -322,6 +323,7 @@ void figure_entertainer_action(figure *f)
             f->action_state == FIGURE_ACTION_94_ENTERTAINER_ROAMING ||
             f->action_state == FIGURE_ACTION_95_ENTERTAINER_RETURNING) {
             f->type = FIGURE_ENEMY54_GLADIATOR;
+            map_figure_update_group(f);
             figure_route_remove(f);
             f->roam_length = 0;
             f->action_state = FIGURE_ACTION_158_NATIVE_CREATED;
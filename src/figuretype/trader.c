@@ -10,11 +10,9 @@
 #include "building/warehouse.h"
 #include "building/storage.h"
 #include "city/buildings.h"
-#include "city/finance.h"
 #include "city/health.h"
 #include "city/map.h"
 #include "city/message.h"
-#include "city/resource.h"
 #include "city/trade.h"
 #include "city/trade_policy.h"
 #include "core/calc.h"
@@ -23,7 +21,6 @@
 #include "empire/city.h"
 #include "empire/empire.h"
 #include "empire/object.h"
-#include "empire/trade_prices.h"
 #include "empire/trade_route.h"
 #include "figure/combat.h"
 #include "figure/image.h"
@@ -218,17 +215,7 @@ static int trader_get_buy_resource(int building_id, int city_id)
         }
         int resource = space->subtype.warehouse_resource_id;
         if (space->loads_stored > 0 && empire_can_export_resource_to_city(city_id, resource)) {
-            // update stocks
-            city_resource_remove_from_warehouse(resource, 1);
-            space->loads_stored--;
-            if (space->loads_stored <= 0) {
-                space->subtype.warehouse_resource_id = RESOURCE_NONE;
-            }
-            // update finances
-            city_finance_process_export(trade_price_sell(resource, 1));
-
-            // update graphics
-            building_warehouse_space_set_image(space, resource);
+            building_warehouse_space_remove_export(space, resource, 1);
             return resource;
         }
     }
@@ -1072,7 +1059,7 @@ int figure_trader_ship_get_distance_to_dock(const figure *ship, int dock_id)
     }
     building *dock = building_get(dock_id);
     map_routing_calculate_distances_water_boat(ship->x, ship->y);
-    uint8_t path[500];
+    uint8_t path[MAX_ROUTING_PATH_LENGTH];
     map_point tile;
     building_dock_get_ship_request_tile(dock, SHIP_DOCK_REQUEST_1_DOCKING, &tile);
     int path_length = map_routing_get_path_on_water(&path[0], tile.x, tile.y, 0);
@@ -327,6 +327,7 @@ void figure_sink_all_ships(void)
         }
         f->building_id = 0;
         f->type = FIGURE_SHIPWRECK;
+        map_figure_update_group(f);
         f->wait_ticks = 0;
     }
 }
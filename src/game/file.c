@@ -395,6 +395,21 @@ int game_file_write_saved_game(const char *filename)
     return game_file_io_write_saved_game(filename);
 }
 
+int game_file_write_saved_game_in_background(const char **filenames, int num_filenames)
+{
+    return game_file_io_write_saved_game_in_background(filenames, num_filenames);
+}
+
+void game_file_check_background_save(void)
+{
+    game_file_io_check_background_save();
+}
+
+void game_file_finish_background_save(void)
+{
+    game_file_io_finish_background_save();
+}
+
 int game_file_delete_saved_game(const char *filename)
 {
     return game_file_io_delete_saved_game(filename);
@@ -38,6 +38,26 @@ int game_file_load_saved_game(const char *filename);
  */
 int game_file_write_saved_game(const char *filename);
 
+/**
+ * Write saved game to disk without blocking the game: the game state is copied right away,
+ * but compressing and writing the files happens on a worker thread when available.
+ * Each file is replaced only when it has been written completely.
+ * @param filenames Files to save the same game state to
+ * @param num_filenames Number of files, at most 2
+ * @return Boolean true if saving was started, false on failure
+ */
+int game_file_write_saved_game_in_background(const char **filenames, int num_filenames);
+
+/**
+ * Completes a saved game that was written in the background, if the worker has finished
+ */
+void game_file_check_background_save(void);
+
+/**
+ * Waits for a saved game that is written in the background to complete
+ */
+void game_file_finish_background_save(void);
+
 /**
  * Delete saved game
  * @param filename File to delete
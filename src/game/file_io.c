@@ -12,8 +12,11 @@
 #include "core/log.h"
 #include "city/message.h"
 #include "city/view.h"
+#include "core/config.h"
 #include "core/dir.h"
+#include "core/lz.h"
 #include "core/random.h"
+#include "core/thread.h"
 #include "core/zip.h"
 #include "empire/city.h"
 #include "empire/empire.h"
@@ -48,6 +51,7 @@
 #include "scenario/scenario.h"
 #include "sound/city.h"
 
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -57,7 +61,16 @@
 
 #define PIECE_SIZE_DYNAMIC 0
 
-static const int SAVE_GAME_CURRENT_VERSION = 0x87;
+#define MAX_SAVE_FILES 2
+
+#define MAX_SAVEGAME_PIECES 100
+#define MAX_COMPRESS_JOBS 8
+
+// the mission and version pieces are written before the piece directory, so the version can be read first
+#define SAVEGAME_HEADER_PIECES 2
+#define PIECE_DIRECTORY_ENTRY_SIZE 16
+
+static const int SAVE_GAME_CURRENT_VERSION = 0x8c;
 
 static const int SAVE_GAME_LAST_ORIGINAL_LIMITS_VERSION = 0x66;
 static const int SAVE_GAME_LAST_SMALLER_IMAGE_ID_VERSION = 0x76;
@@ -71,6 +84,11 @@ static const int SAVE_GAME_LAST_STORED_IMAGE_IDS = 0x83;
 static const int SAVE_GAME_INCREASE_GRANARY_CAPACITY = 0x85;
 // static const int SAVE_GAME_ROADBLOCK_DATA_MOVED_FROM_SUBTYPE = 0x86; This define is unneeded for now
 static const int SAVE_GAME_LAST_ORIGINAL_TERRAIN_DATA_SIZE_VERSION = 0x86;
+static const int SAVE_GAME_LAST_16_BIT_IDS_VERSION = 0x87;
+static const int SAVE_GAME_LAST_FIXED_ROUTE_PATHS_VERSION = 0x88;
+static const int SAVE_GAME_LAST_IMPLODE_ONLY_VERSION = 0x89;
+static const int SAVE_GAME_LAST_NO_PIECE_DIRECTORY_VERSION = 0x8a;
+static const int SAVE_GAME_LAST_16_BIT_DOCK_IDS_VERSION = 0x8b;
 
 
 static char compress_buffer[COMPRESS_BUFFER_SIZE];
@@ -189,10 +207,60 @@ typedef struct {
 
 static struct {
     int num_pieces;
-    file_piece pieces[100];
+    file_piece pieces[MAX_SAVEGAME_PIECES];
     savegame_state state;
+    uint8_t *piece_data;
+    uint8_t *file_data;
 } savegame_data;
 
+typedef enum {
+    SAVEGAME_CODEC_NONE = 0,
+    SAVEGAME_CODEC_IMPLODE = 1,
+    SAVEGAME_CODEC_LZ = 2
+} savegame_codec;
+
+typedef struct {
+    int offset;
+    savegame_codec codec;
+    int size;
+    int stored_size;
+} piece_directory_entry;
+
+typedef struct {
+    FILE *fp;
+    int available;
+    uint8_t *data;
+    int size;
+    int capacity;
+} file_reader;
+
+typedef struct {
+    FILE *fp[MAX_SAVE_FILES];
+    int num_files;
+    savegame_codec codec;
+    zip_compression_level compression_level;
+} save_files;
+
+typedef struct {
+    uint8_t *data;
+    int size;
+} compressed_piece;
+
+typedef struct {
+    int pieces[MAX_SAVEGAME_PIECES];
+    int num_pieces;
+    int total_size;
+    const save_files *files;
+    compressed_piece *results;
+} compress_job;
+
+static struct {
+    thread *thread;
+    save_files files;
+    char filenames[MAX_SAVE_FILES][FILE_NAME_MAX];
+    char temp_filenames[MAX_SAVE_FILES][FILE_NAME_MAX];
+} background_save;
+
 static void init_file_piece(file_piece *piece, int size, int compressed)
 {
     piece->compressed = compressed;
@@ -216,16 +284,56 @@ static buffer *create_scenario_piece(int size)
 static buffer *create_savegame_piece(int size, int compressed)
 {
     file_piece *piece = &savegame_data.pieces[savegame_data.num_pieces++];
-    init_file_piece(piece, size, compressed);
+    piece->compressed = compressed;
+    piece->dynamic = size == PIECE_SIZE_DYNAMIC;
+    // memory is assigned by allocate_savegame_pieces() when saving and by load_savegame_pieces() when loading
+    buffer_init(&piece->buf, 0, size);
     return &piece->buf;
 }
 
+static int allocate_savegame_pieces(void)
+{
+    int total_size = 0;
+    for (int i = 0; i < savegame_data.num_pieces; i++) {
+        total_size += savegame_data.pieces[i].buf.size;
+    }
+    savegame_data.piece_data = malloc(total_size);
+    if (!savegame_data.piece_data) {
+        return 0;
+    }
+    memset(savegame_data.piece_data, 0, total_size);
+    uint8_t *data = savegame_data.piece_data;
+    for (int i = 0; i < savegame_data.num_pieces; i++) {
+        file_piece *piece = &savegame_data.pieces[i];
+        if (!piece->dynamic) {
+            buffer_init(&piece->buf, data, piece->buf.size);
+            data += piece->buf.size;
+        }
+    }
+    return 1;
+}
+
+static void release_loaded_savegame_pieces(void)
+{
+    for (int i = 0; i < savegame_data.num_pieces; i++) {
+        buffer_init(&savegame_data.pieces[i].buf, 0, 0);
+    }
+    free(savegame_data.piece_data);
+    free(savegame_data.file_data);
+    savegame_data.piece_data = 0;
+    savegame_data.file_data = 0;
+}
+
 static void clear_savegame_pieces(void)
 {
     for (int i = 0; i < savegame_data.num_pieces; i++) {
-        buffer_reset(&savegame_data.pieces[i].buf);
-        free(savegame_data.pieces[i].buf.data);
+        // when saving, dynamic pieces are allocated by the modules that fill them
+        if (savegame_data.pieces[i].dynamic) {
+            free(savegame_data.pieces[i].buf.data);
+        }
     }
+    free(savegame_data.piece_data);
+    savegame_data.piece_data = 0;
     savegame_data.num_pieces = 0;
 }
 
@@ -271,6 +379,8 @@ static void init_savegame_data(int version)
 
     int image_grid_size = 52488 * (version > SAVE_GAME_LAST_SMALLER_IMAGE_ID_VERSION ? 2 : 1);
     int terrain_grid_size = 52488 * (version > SAVE_GAME_LAST_ORIGINAL_TERRAIN_DATA_SIZE_VERSION ? 2 : 1);
+    int id_grid_size = 52488 * (version > SAVE_GAME_LAST_16_BIT_IDS_VERSION ? 2 : 1);
+    int city_data_size = 36136 + (version > SAVE_GAME_LAST_16_BIT_DOCK_IDS_VERSION ? 40 : 0);
     int figures_size = 128000 * multiplier;
     int route_figures_size = 1200 * multiplier;
     int route_paths_size = 300000 * multiplier;
@@ -296,10 +406,10 @@ static void init_savegame_data(int version)
         state->image_grid = create_savegame_piece(image_grid_size, 1);
     }
     state->edge_grid = create_savegame_piece(26244, 1);
-    state->building_grid = create_savegame_piece(52488, 1);
+    state->building_grid = create_savegame_piece(id_grid_size, 1);
     state->terrain_grid = create_savegame_piece(terrain_grid_size, 1);
     state->aqueduct_grid = create_savegame_piece(26244, 1);
-    state->figure_grid = create_savegame_piece(52488, 1);
+    state->figure_grid = create_savegame_piece(id_grid_size, 1);
     state->bitfields_grid = create_savegame_piece(26244, 1);
     state->sprite_grid = create_savegame_piece(26244, 1);
     state->random_grid = create_savegame_piece(26244, 0);
@@ -313,7 +423,7 @@ static void init_savegame_data(int version)
     state->route_paths = create_savegame_piece(route_paths_size, 1);
     state->formations = create_savegame_piece(formations_size, 1);
     state->formation_totals = create_savegame_piece(12, 0);
-    state->city_data = create_savegame_piece(36136, 1);
+    state->city_data = create_savegame_piece(city_data_size, 1);
     state->city_faction_unknown = create_savegame_piece(2, 0);
     state->player_name = create_savegame_piece(64, 0);
     state->city_faction = create_savegame_piece(4, 0);
@@ -425,19 +535,21 @@ static void savegame_load_from_state(savegame_state *state, int version)
     scenario_load_state(state->scenario);
     scenario_map_init();
 
-    map_building_load_state(state->building_grid, state->building_damage_grid);
+    map_building_load_state(state->building_grid, state->building_damage_grid,
+        version > SAVE_GAME_LAST_16_BIT_IDS_VERSION);
     map_terrain_load_state(state->terrain_grid, version > SAVE_GAME_LAST_ORIGINAL_TERRAIN_DATA_SIZE_VERSION,
         version <= SAVE_GAME_LAST_STORED_IMAGE_IDS ? state->image_grid : 0,
         version <= SAVE_GAME_LAST_SMALLER_IMAGE_ID_VERSION);
     map_aqueduct_load_state(state->aqueduct_grid, state->aqueduct_backup_grid);
-    map_figure_load_state(state->figure_grid);
+    map_figure_load_state(state->figure_grid, version > SAVE_GAME_LAST_16_BIT_IDS_VERSION);
     map_sprite_load_state(state->sprite_grid, state->sprite_backup_grid);
     map_property_load_state(state->bitfields_grid, state->edge_grid);
     map_random_load_state(state->random_grid);
     map_desirability_load_state(state->desirability_grid);
     map_elevation_load_state(state->elevation_grid);
     figure_load_state(state->figures, state->figure_sequence, version > SAVE_GAME_LAST_STATIC_VERSION);
-    figure_route_load_state(state->route_figures, state->route_paths);
+    figure_route_load_state(state->route_figures, state->route_paths, version > SAVE_GAME_LAST_16_BIT_IDS_VERSION,
+        version > SAVE_GAME_LAST_FIXED_ROUTE_PATHS_VERSION);
     formations_load_state(state->formations, state->formation_totals, version > SAVE_GAME_LAST_STATIC_VERSION);
 
     city_data_load_state(state->city_data,
@@ -446,7 +558,8 @@ static void savegame_load_from_state(savegame_state *state, int version)
         state->city_graph_order,
         state->city_entry_exit_xy,
         state->city_entry_exit_grid_offset,
-        version > SAVE_GAME_LAST_JOINED_IMPORT_EXPORT_VERSION);
+        version > SAVE_GAME_LAST_JOINED_IMPORT_EXPORT_VERSION,
+        version > SAVE_GAME_LAST_16_BIT_DOCK_IDS_VERSION);
 
     building_load_state(state->buildings,
         state->building_extra_sequence,
@@ -470,7 +583,7 @@ static void savegame_load_from_state(savegame_state *state, int version)
 
     scenario_emperor_change_load_state(state->emperor_change_time, state->emperor_change_state);
     empire_load_state(state->empire);
-    empire_city_load_state(state->empire_cities);
+    empire_city_load_state(state->empire_cities, version > SAVE_GAME_LAST_16_BIT_IDS_VERSION);
     trade_prices_load_state(state->trade_prices);
     figure_name_load_state(state->figure_names);
     city_culture_load_state(state->culture_coverage);
@@ -633,106 +746,513 @@ int game_file_io_write_scenario(const char *filename)
     return 1;
 }
 
-static int read_int32(FILE *fp)
+static void write_to_files(save_files *files, const void *data, int size)
 {
-    uint8_t data[4];
-    if (fread(&data, 1, 4, fp) != 4) {
-        return 0;
+    for (int i = 0; i < files->num_files; i++) {
+        fwrite(data, 1, size, files->fp[i]);
     }
-    buffer buf;
-    buffer_init(&buf, data, 4);
-    return buffer_read_i32(&buf);
 }
 
-static void write_int32(FILE *fp, int value)
+static void write_int32(save_files *files, int value)
 {
     uint8_t data[4];
     buffer buf;
     buffer_init(&buf, data, 4);
     buffer_write_i32(&buf, value);
-    fwrite(&data, 1, 4, fp);
+    write_to_files(files, data, 4);
 }
 
-static int read_compressed_chunk(FILE *fp, void *buffer, int bytes_to_read)
+static int read_int32(uint8_t *data, int size, int *offset, int *value)
 {
-    if (bytes_to_read > COMPRESS_BUFFER_SIZE) {
+    if (size - *offset < 4) {
         return 0;
     }
-    int input_size = read_int32(fp);
-    if ((unsigned int) input_size == UNCOMPRESSED) {
-        if (fread(buffer, 1, bytes_to_read, fp) != bytes_to_read) {
+    buffer buf;
+    buffer_init(&buf, &data[*offset], 4);
+    *value = buffer_read_i32(&buf);
+    *offset += 4;
+    return 1;
+}
+
+static int init_file_reader(file_reader *reader, FILE *fp)
+{
+    memset(reader, 0, sizeof(file_reader));
+    reader->fp = fp;
+    long start = ftell(fp);
+    if (start < 0 || fseek(fp, 0, SEEK_END)) {
+        return 0;
+    }
+    long end = ftell(fp);
+    if (end < start || fseek(fp, start, SEEK_SET)) {
+        return 0;
+    }
+    reader->available = end - start < INT_MAX / 2 ? (int) (end - start) : INT_MAX / 2;
+    return 1;
+}
+
+static int read_file_data(file_reader *reader, int size)
+{
+    // reads up to size bytes from the start of the saved game, or less when the file ends sooner
+    if (size > reader->available) {
+        size = reader->available;
+    }
+    if (size <= reader->size) {
+        return 1;
+    }
+    if (size > reader->capacity) {
+        int capacity = reader->capacity * 2 > size ? reader->capacity * 2 : size;
+        if (capacity > reader->available) {
+            capacity = reader->available;
+        }
+        uint8_t *data = realloc(reader->data, capacity);
+        if (!data) {
             return 0;
         }
-    } else {
-        if (fread(compress_buffer, 1, input_size, fp) != input_size
-            || !zip_decompress(compress_buffer, input_size, buffer, &bytes_to_read)) {
+        reader->data = data;
+        reader->capacity = capacity;
+    }
+    if (fread(&reader->data[reader->size], 1, size - reader->size, reader->fp) != size - reader->size) {
+        return 0;
+    }
+    reader->size = size;
+    return 1;
+}
+
+static int read_piece_directory(uint8_t *data, int size, piece_directory_entry *directory)
+{
+    int offset = 0;
+    for (int i = 0; i < SAVEGAME_HEADER_PIECES; i++) {
+        offset += savegame_data.pieces[i].buf.size;
+    }
+    int num_pieces;
+    if (!read_int32(data, size, &offset, &num_pieces) || num_pieces != savegame_data.num_pieces) {
+        return 0;
+    }
+    for (int i = 0; i < num_pieces; i++) {
+        piece_directory_entry *entry = &directory[i];
+        int codec;
+        if (!read_int32(data, size, &offset, &entry->offset) ||
+            !read_int32(data, size, &offset, &codec) ||
+            !read_int32(data, size, &offset, &entry->size) ||
+            !read_int32(data, size, &offset, &entry->stored_size)) {
             return 0;
         }
+        entry->codec = codec;
     }
     return 1;
 }
 
-static int write_compressed_chunk(FILE *fp, const void *buffer, int bytes_to_write)
+static int read_chunk_header(uint8_t *data, int size, int *offset, int version, piece_directory_entry *entry)
 {
-    if (bytes_to_write > COMPRESS_BUFFER_SIZE) {
+    if (version > SAVE_GAME_LAST_IMPLODE_ONLY_VERSION) {
+        int codec;
+        if (!read_int32(data, size, offset, &codec) || !read_int32(data, size, offset, &entry->stored_size)) {
+            return 0;
+        }
+        entry->codec = codec;
+        return 1;
+    }
+    if (!read_int32(data, size, offset, &entry->stored_size)) {
         return 0;
     }
-    int output_size = COMPRESS_BUFFER_SIZE;
-    if (zip_compress(buffer, bytes_to_write, compress_buffer, &output_size)) {
-        write_int32(fp, output_size);
-        fwrite(compress_buffer, 1, output_size, fp);
+    if ((unsigned int) entry->stored_size == UNCOMPRESSED) {
+        entry->codec = SAVEGAME_CODEC_NONE;
+        entry->stored_size = entry->size;
     } else {
-        // unable to compress: write uncompressed
-        write_int32(fp, UNCOMPRESSED);
-        fwrite(buffer, 1, bytes_to_write, fp);
+        entry->codec = SAVEGAME_CODEC_IMPLODE;
     }
     return 1;
 }
 
-static int savegame_read_from_file(FILE *fp)
+static void scan_piece_directory(uint8_t *data, int size, int version, piece_directory_entry *directory)
 {
+    // saved games without a directory store the pieces one after the other, with a header in front of
+    // dynamic and compressed pieces: walk the headers to find where every piece is
+    int offset = 0;
     for (int i = 0; i < savegame_data.num_pieces; i++) {
-        file_piece *piece = &savegame_data.pieces[i];
-        int result = 0;
+        const file_piece *piece = &savegame_data.pieces[i];
+        piece_directory_entry *entry = &directory[i];
+        entry->codec = SAVEGAME_CODEC_NONE;
+        entry->size = piece->buf.size;
+        if (piece->dynamic && !read_int32(data, size, &offset, &entry->size)) {
+            entry->size = 0;
+        }
+        entry->stored_size = entry->size;
+        if (piece->compressed && entry->size && !read_chunk_header(data, size, &offset, version, entry)) {
+            // the piece is missing: there is nothing more to read
+            offset = size;
+        }
+        entry->offset = offset;
+        offset = entry->stored_size >= 0 && entry->stored_size <= size - offset ? offset + entry->stored_size : size;
+    }
+}
+
+static int is_valid_piece_directory(int size, const piece_directory_entry *directory)
+{
+    for (int i = 0; i < savegame_data.num_pieces; i++) {
+        const file_piece *piece = &savegame_data.pieces[i];
+        const piece_directory_entry *entry = &directory[i];
+        if (entry->offset < 0 || entry->offset > size || entry->size < 0 || entry->stored_size < 0 ||
+            (!piece->dynamic && entry->size != piece->buf.size)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int can_use_piece_in_place(int size, const piece_directory_entry *entry)
+{
+    return entry->codec == SAVEGAME_CODEC_NONE && entry->stored_size == entry->size &&
+        entry->stored_size <= size - entry->offset;
+}
+
+static int decode_piece(uint8_t *data, int size, const piece_directory_entry *entry, uint8_t *output)
+{
+    const uint8_t *input = &data[entry->offset];
+    int available = size - entry->offset;
+    memset(output, 0, entry->size);
+    if (entry->stored_size > available) {
+        if (entry->codec == SAVEGAME_CODEC_NONE) {
+            memcpy(output, input, available < entry->size ? available : entry->size);
+        }
+        return 0;
+    }
+    int output_size = entry->size;
+    switch (entry->codec) {
+        case SAVEGAME_CODEC_IMPLODE:
+            return zip_decompress(input, entry->stored_size, output, &output_size);
+        case SAVEGAME_CODEC_LZ:
+            return lz_decompress(input, entry->stored_size, output, &output_size);
+        case SAVEGAME_CODEC_NONE:
+            return 0;
+        default:
+            log_error("Unknown compression in saved game:", 0, entry->codec);
+            return 0;
+    }
+}
+
+static int read_saved_game_with_directory(file_reader *reader)
+{
+    int directory_end = 4 + savegame_data.num_pieces * PIECE_DIRECTORY_ENTRY_SIZE;
+    for (int i = 0; i < SAVEGAME_HEADER_PIECES; i++) {
+        directory_end += savegame_data.pieces[i].buf.size;
+    }
+    if (!read_file_data(reader, directory_end)) {
+        return 0;
+    }
+    piece_directory_entry directory[MAX_SAVEGAME_PIECES];
+    if (!read_piece_directory(reader->data, reader->size, directory)) {
+        // reported when the pieces are loaded
+        return 1;
+    }
+    int end = reader->size;
+    for (int i = 0; i < savegame_data.num_pieces; i++) {
+        const piece_directory_entry *entry = &directory[i];
+        if (entry->offset >= 0 && entry->stored_size >= 0 && entry->offset <= INT_MAX - entry->stored_size &&
+            entry->offset + entry->stored_size > end) {
+            end = entry->offset + entry->stored_size;
+        }
+    }
+    return read_file_data(reader, end);
+}
+
+static int read_saved_game_without_directory(file_reader *reader, int version)
+{
+    // without a directory, the end of the saved game is only known after walking all piece headers
+    for (int i = 0; i < savegame_data.num_pieces; i++) {
+        const file_piece *piece = &savegame_data.pieces[i];
+        piece_directory_entry entry;
+        int offset = reader->size;
+        entry.size = piece->buf.size;
         if (piece->dynamic) {
-            int size = read_int32(fp);
-            if (!size) {
-                continue;
+            if (!read_file_data(reader, offset + 4)) {
+                return 0;
+            }
+            if (!read_int32(reader->data, reader->size, &offset, &entry.size)) {
+                break;
             }
-            uint8_t *data = malloc(size);
-            memset(data, 0, size);
-            buffer_init(&piece->buf, data, size);
         }
-        if (piece->compressed) {
-            result = read_compressed_chunk(fp, piece->buf.data, piece->buf.size);
-        } else {
-            result = fread(piece->buf.data, 1, piece->buf.size, fp) == piece->buf.size;
+        entry.stored_size = entry.size;
+        if (piece->compressed && entry.size) {
+            if (!read_file_data(reader, offset + (version > SAVE_GAME_LAST_IMPLODE_ONLY_VERSION ? 8 : 4))) {
+                return 0;
+            }
+            if (!read_chunk_header(reader->data, reader->size, &offset, version, &entry)) {
+                break;
+            }
         }
-        // The last piece may be smaller than buf.size
-        if (!result && i != (savegame_data.num_pieces - 1)) {
-            log_info("Incorrect buffer size, got", 0, result);
-            log_info("Incorrect buffer size, expected", 0, piece->buf.size);
+        if (entry.stored_size < 0 || entry.stored_size > reader->available - offset) {
+            // the rest of the file is all there is
+            return read_file_data(reader, reader->available);
+        }
+        if (!read_file_data(reader, offset + entry.stored_size)) {
             return 0;
         }
     }
     return 1;
 }
 
-static void savegame_write_to_file(FILE *fp)
+static int load_savegame_pieces(uint8_t *data, int size, int version)
 {
+    piece_directory_entry directory[MAX_SAVEGAME_PIECES];
+    if (version > SAVE_GAME_LAST_NO_PIECE_DIRECTORY_VERSION) {
+        if (!read_piece_directory(data, size, directory)) {
+            log_error("Unable to read the piece directory", 0, 0);
+            return 0;
+        }
+    } else {
+        scan_piece_directory(data, size, version, directory);
+    }
+    if (!is_valid_piece_directory(size, directory)) {
+        log_error("Invalid piece directory", 0, 0);
+        return 0;
+    }
+    // raw pieces are used straight from the file data, all others are decoded into a single allocation
+    int decoded_size = 0;
+    for (int i = 0; i < savegame_data.num_pieces; i++) {
+        if (!can_use_piece_in_place(size, &directory[i])) {
+            if (directory[i].size > INT_MAX - decoded_size) {
+                return 0;
+            }
+            decoded_size += directory[i].size;
+        }
+    }
+    if (decoded_size) {
+        savegame_data.piece_data = malloc(decoded_size);
+        if (!savegame_data.piece_data) {
+            return 0;
+        }
+    }
+    uint8_t *piece_data = savegame_data.piece_data;
     for (int i = 0; i < savegame_data.num_pieces; i++) {
         file_piece *piece = &savegame_data.pieces[i];
-        if (piece->dynamic) {
-            write_int32(fp, piece->buf.size);
-            if (!piece->buf.size) {
-                continue;
+        const piece_directory_entry *entry = &directory[i];
+        if (can_use_piece_in_place(size, entry)) {
+            buffer_init(&piece->buf, entry->size ? &data[entry->offset] : 0, entry->size);
+            continue;
+        }
+        buffer_init(&piece->buf, piece_data, entry->size);
+        piece_data += entry->size;
+        // The last piece may be smaller than buf.size
+        if (!decode_piece(data, size, entry, piece->buf.data) && i != (savegame_data.num_pieces - 1)) {
+            log_info("Incorrect buffer size, expected", 0, entry->size);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int compress_chunk(const save_files *files, const void *buffer, int bytes_to_write,
+    void *output_buffer, int *output_size)
+{
+    if (files->codec == SAVEGAME_CODEC_LZ) {
+        // only worth it when the piece gets smaller
+        return lz_compress(buffer, bytes_to_write, output_buffer, output_size) && *output_size < bytes_to_write;
+    }
+    return zip_compress(buffer, bytes_to_write, output_buffer, output_size, files->compression_level);
+}
+
+static int compress_pieces(void *data)
+{
+    compress_job *job = data;
+    uint8_t *scratch = malloc(COMPRESS_BUFFER_SIZE);
+    if (!scratch) {
+        return 0;
+    }
+    for (int i = 0; i < job->num_pieces; i++) {
+        const file_piece *piece = &savegame_data.pieces[job->pieces[i]];
+        compressed_piece *result = &job->results[job->pieces[i]];
+        int output_size = COMPRESS_BUFFER_SIZE;
+        if (compress_chunk(job->files, piece->buf.data, piece->buf.size, scratch, &output_size)) {
+            result->data = malloc(output_size);
+            if (result->data) {
+                memcpy(result->data, scratch, output_size);
+                result->size = output_size;
             }
         }
-        if (piece->compressed) {
-            write_compressed_chunk(fp, piece->buf.data, piece->buf.size);
+    }
+    free(scratch);
+    return 1;
+}
+
+static int can_compress(const file_piece *piece)
+{
+    return piece->compressed && piece->buf.size > 0 && piece->buf.size <= COMPRESS_BUFFER_SIZE;
+}
+
+static int assign_pieces_to_compress_jobs(compress_job *jobs, int num_jobs)
+{
+    int assigned[MAX_SAVEGAME_PIECES] = { 0 };
+    int num_assigned = 0;
+    while (1) {
+        // largest piece first, to the job with the least work, so the jobs end at about the same time
+        int largest = -1;
+        for (int i = 0; i < savegame_data.num_pieces; i++) {
+            const file_piece *piece = &savegame_data.pieces[i];
+            if (!assigned[i] && can_compress(piece) &&
+                (largest < 0 || piece->buf.size > savegame_data.pieces[largest].buf.size)) {
+                largest = i;
+            }
+        }
+        if (largest < 0) {
+            return num_assigned;
+        }
+        compress_job *job = &jobs[0];
+        for (int i = 1; i < num_jobs; i++) {
+            if (jobs[i].total_size < job->total_size) {
+                job = &jobs[i];
+            }
+        }
+        job->pieces[job->num_pieces++] = largest;
+        job->total_size += savegame_data.pieces[largest].buf.size;
+        assigned[largest] = 1;
+        num_assigned++;
+    }
+}
+
+static void compress_savegame_pieces(compressed_piece *results, const save_files *files)
+{
+    int num_jobs = thread_get_core_count();
+    if (num_jobs > MAX_COMPRESS_JOBS) {
+        num_jobs = MAX_COMPRESS_JOBS;
+    }
+    if (num_jobs < 1) {
+        num_jobs = 1;
+    }
+    compress_job jobs[MAX_COMPRESS_JOBS];
+    thread *threads[MAX_COMPRESS_JOBS];
+    memset(jobs, 0, sizeof(jobs));
+    for (int i = 0; i < num_jobs; i++) {
+        jobs[i].files = files;
+        jobs[i].results = results;
+    }
+    assign_pieces_to_compress_jobs(jobs, num_jobs);
+    for (int i = 1; i < num_jobs; i++) {
+        threads[i] = jobs[i].num_pieces ? thread_create(compress_pieces, &jobs[i]) : 0;
+    }
+    compress_pieces(&jobs[0]);
+    for (int i = 1; i < num_jobs; i++) {
+        if (threads[i]) {
+            thread_wait(threads[i]);
+        } else if (jobs[i].num_pieces) {
+            // no thread available: compress the pieces here
+            compress_pieces(&jobs[i]);
+        }
+    }
+}
+
+static void write_piece_directory(save_files *files, const piece_directory_entry *directory)
+{
+    write_int32(files, savegame_data.num_pieces);
+    for (int i = 0; i < savegame_data.num_pieces; i++) {
+        write_int32(files, directory[i].offset);
+        write_int32(files, directory[i].codec);
+        write_int32(files, directory[i].size);
+        write_int32(files, directory[i].stored_size);
+    }
+}
+
+static void savegame_write_to_files(save_files *files)
+{
+    // all pieces are compressed before writing, as the directory needs their sizes
+    compressed_piece results[MAX_SAVEGAME_PIECES];
+    memset(results, 0, sizeof(results));
+    compress_savegame_pieces(results, files);
+
+    piece_directory_entry directory[MAX_SAVEGAME_PIECES];
+    int offset = 0;
+    for (int i = 0; i < savegame_data.num_pieces; i++) {
+        if (i == SAVEGAME_HEADER_PIECES) {
+            offset += 4 + savegame_data.num_pieces * PIECE_DIRECTORY_ENTRY_SIZE;
+        }
+        piece_directory_entry *entry = &directory[i];
+        entry->offset = offset;
+        entry->size = savegame_data.pieces[i].buf.size;
+        if (results[i].data) {
+            entry->codec = files->codec;
+            entry->stored_size = results[i].size;
         } else {
-            fwrite(piece->buf.data, 1, piece->buf.size, fp);
+            entry->codec = SAVEGAME_CODEC_NONE;
+            entry->stored_size = entry->size;
+        }
+        offset += entry->stored_size;
+    }
+    for (int i = 0; i < savegame_data.num_pieces; i++) {
+        if (i == SAVEGAME_HEADER_PIECES) {
+            write_piece_directory(files, directory);
         }
+        if (results[i].data) {
+            write_to_files(files, results[i].data, results[i].size);
+            free(results[i].data);
+        } else if (directory[i].size) {
+            write_to_files(files, savegame_data.pieces[i].buf.data, directory[i].size);
+        }
+    }
+}
+
+static int copy_file(const char *filename, const char *new_filename)
+{
+    FILE *in = file_open(filename, "rb");
+    if (!in) {
+        return 0;
+    }
+    FILE *out = file_open(new_filename, "wb");
+    if (!out) {
+        file_close(in);
+        return 0;
+    }
+    int result = 1;
+    size_t size;
+    while ((size = fread(compress_buffer, 1, COMPRESS_BUFFER_SIZE, in)) > 0) {
+        if (fwrite(compress_buffer, 1, size, out) != size) {
+            result = 0;
+            break;
+        }
+    }
+    file_close(in);
+    return file_close(out) && result;
+}
+
+static int write_saved_game_in_background(void *data)
+{
+    save_files *files = data;
+    savegame_write_to_files(files);
+    for (int i = 0; i < files->num_files; i++) {
+        fflush(files->fp[i]);
+    }
+    return 1;
+}
+
+static int complete_background_save(void)
+{
+    int result = 1;
+    for (int i = 0; i < background_save.files.num_files; i++) {
+        const char *filename = background_save.filenames[i];
+        const char *temp_filename = background_save.temp_filenames[i];
+        int written = !ferror(background_save.files.fp[i]);
+        written = file_close(background_save.files.fp[i]) && written;
+        // replace the saved game only when it is complete, so a crash never leaves a broken file
+        if (written && !file_rename(temp_filename, filename)) {
+            written = copy_file(temp_filename, filename);
+            file_remove(temp_filename);
+        } else if (!written) {
+            file_remove(temp_filename);
+        }
+        if (!written) {
+            log_error("Unable to save game", filename, 0);
+            result = 0;
+        }
+    }
+    background_save.files.num_files = 0;
+    return result;
+}
+
+static void finish_background_save(void)
+{
+    if (background_save.thread) {
+        thread_wait(background_save.thread);
+        background_save.thread = 0;
+        complete_background_save();
     }
 }
 
@@ -751,6 +1271,7 @@ static int get_savegame_version(FILE *fp)
 
 int game_file_io_read_saved_game(const char *filename, int offset)
 {
+    finish_background_save();
     log_info("Loading saved game", filename, 0);
     FILE *fp = file_open(dir_get_file(filename, NOT_LOCALIZED), "rb");
     if (!fp) {
@@ -769,20 +1290,33 @@ int game_file_io_read_saved_game(const char *filename, int offset)
         }
         log_info("Savegame version", 0, version);
         init_savegame_data(version);
-        result = savegame_read_from_file(fp);
+        file_reader reader;
+        if (init_file_reader(&reader, fp)) {
+            result = version > SAVE_GAME_LAST_NO_PIECE_DIRECTORY_VERSION ?
+                read_saved_game_with_directory(&reader) : read_saved_game_without_directory(&reader, version);
+            savegame_data.file_data = reader.data;
+            result = result && reader.size && load_savegame_pieces(reader.data, reader.size, version);
+        }
     }
     file_close(fp);
     if (!result) {
+        release_loaded_savegame_pieces();
         log_error("Unable to load game, unable to read savefile.", 0, 0);
         return 0;
     }
     savegame_load_from_state(&savegame_data.state, version);
+    release_loaded_savegame_pieces();
     return 1;
 }
 
 int game_file_io_write_saved_game(const char *filename)
 {
+    finish_background_save();
     init_savegame_data(SAVE_GAME_CURRENT_VERSION);
+    if (!allocate_savegame_pieces()) {
+        log_error("Unable to save game, out of memory", 0, 0);
+        return 0;
+    }
 
     log_info("Saving game", filename, 0);
     savegame_save_to_state(&savegame_data.state);
@@ -792,13 +1326,70 @@ int game_file_io_write_saved_game(const char *filename)
         log_error("Unable to save game", 0, 0);
         return 0;
     }
-    savegame_write_to_file(fp);
+    save_files files = { { fp }, 1, SAVEGAME_CODEC_IMPLODE, ZIP_COMPRESSION_BEST };
+    savegame_write_to_files(&files);
     file_close(fp);
     return 1;
 }
 
+int game_file_io_write_saved_game_in_background(const char **filenames, int num_filenames)
+{
+    finish_background_save();
+    init_savegame_data(SAVE_GAME_CURRENT_VERSION);
+    if (!allocate_savegame_pieces()) {
+        log_error("Unable to save game, out of memory", 0, 0);
+        return 0;
+    }
+
+    log_info("Saving game in the background", filenames[0], 0);
+    savegame_save_to_state(&savegame_data.state);
+
+    save_files *files = &background_save.files;
+    // background saves are autosaves, which are written often, so trade a little size for speed
+    files->codec = config_get(CONFIG_GENERAL_FAST_AUTOSAVES) ? SAVEGAME_CODEC_LZ : SAVEGAME_CODEC_IMPLODE;
+    files->compression_level = ZIP_COMPRESSION_FAST;
+    for (int i = 0; i < num_filenames && files->num_files < MAX_SAVE_FILES; i++) {
+        char *filename = background_save.filenames[files->num_files];
+        char *temp_filename = background_save.temp_filenames[files->num_files];
+        if (snprintf(temp_filename, FILE_NAME_MAX, "%s.tmp", filenames[i]) >= FILE_NAME_MAX) {
+            log_error("Unable to save game, filename too long", filenames[i], 0);
+            continue;
+        }
+        FILE *fp = file_open(temp_filename, "wb");
+        if (!fp) {
+            log_error("Unable to save game", filenames[i], 0);
+            continue;
+        }
+        snprintf(filename, FILE_NAME_MAX, "%s", filenames[i]);
+        files->fp[files->num_files++] = fp;
+    }
+    if (!files->num_files) {
+        return 0;
+    }
+    background_save.thread = thread_create(write_saved_game_in_background, files);
+    if (!background_save.thread) {
+        // no threads available: write the files right away
+        write_saved_game_in_background(files);
+        return complete_background_save();
+    }
+    return 1;
+}
+
+void game_file_io_check_background_save(void)
+{
+    if (background_save.thread && thread_is_finished(background_save.thread)) {
+        finish_background_save();
+    }
+}
+
+void game_file_io_finish_background_save(void)
+{
+    finish_background_save();
+}
+
 int game_file_io_delete_saved_game(const char *filename)
 {
+    finish_background_save();
     log_info("Deleting game", filename, 0);
     int result = file_remove(filename);
     if (!result) {
@@ -9,6 +9,12 @@ int game_file_io_read_saved_game(const char *filename, int offset);
 
 int game_file_io_write_saved_game(const char *filename);
 
+int game_file_io_write_saved_game_in_background(const char **filenames, int num_filenames);
+
+void game_file_io_check_background_save(void);
+
+void game_file_io_finish_background_save(void);
+
 int game_file_io_delete_saved_game(const char *filename);
 
 #endif // GAME_FILE_IO_H
@@ -16,6 +16,7 @@
 #include "game/animation.h"
 #include "game/file.h"
 #include "game/file_editor.h"
+#include "game/profiler.h"
 #include "game/settings.h"
 #include "game/speed.h"
 #include "game/state.h"
@@ -180,16 +181,20 @@ void game_run(void)
             break;
         }
     }
+    game_file_check_background_save();
 }
 
 void game_draw(void)
 {
+    PROFILER_START(draw_timer);
     window_draw(0);
+    PROFILER_STOP(PROFILER_SECTION_DRAW, draw_timer);
     sound_city_play();
 }
 
 void game_exit(void)
 {
+    game_file_finish_background_save();
     video_shutdown();
     settings_save();
     config_save();
@@ -0,0 +1,145 @@
+#include "profiler.h"
+
+#include "core/file.h"
+#include "game/system.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef DRAW_FPS
+
+#define MAX_SAMPLES 128
+
+typedef struct {
+    uint32_t samples[MAX_SAMPLES];
+    int num_samples;
+    int next_sample;
+    uint32_t pending;
+    int has_pending;
+} section_data;
+
+static struct {
+    section_data sections[PROFILER_SECTION_MAX];
+} data;
+
+static void record_sample(section_data *section, uint64_t microseconds)
+{
+    section->samples[section->next_sample] = microseconds > UINT32_MAX ? UINT32_MAX : (uint32_t) microseconds;
+    section->next_sample = (section->next_sample + 1) % MAX_SAMPLES;
+    if (section->num_samples < MAX_SAMPLES) {
+        section->num_samples++;
+    }
+}
+
+uint64_t profiler_start(void)
+{
+    return system_get_microseconds();
+}
+
+void profiler_stop(profiler_section section, uint64_t timer)
+{
+    record_sample(&data.sections[section], system_get_microseconds() - timer);
+}
+
+void profiler_add(profiler_section section, uint64_t timer)
+{
+    section_data *s = &data.sections[section];
+    s->pending += (uint32_t) (system_get_microseconds() - timer);
+    s->has_pending = 1;
+}
+
+void profiler_commit(void)
+{
+    for (int i = 0; i < PROFILER_SECTION_MAX; i++) {
+        section_data *s = &data.sections[i];
+        if (s->has_pending) {
+            record_sample(s, s->pending);
+            s->pending = 0;
+            s->has_pending = 0;
+        }
+    }
+}
+
+static int compare_samples(const void *a, const void *b)
+{
+    uint32_t sa = *(const uint32_t *) a;
+    uint32_t sb = *(const uint32_t *) b;
+    return sa < sb ? -1 : (sa > sb ? 1 : 0);
+}
+
+void profiler_get_stats(profiler_section section, profiler_stats *stats)
+{
+    memset(stats, 0, sizeof(profiler_stats));
+    const section_data *s = &data.sections[section];
+    if (!s->num_samples) {
+        return;
+    }
+    uint32_t sorted[MAX_SAMPLES];
+    memcpy(sorted, s->samples, sizeof(uint32_t) * s->num_samples);
+    qsort(sorted, s->num_samples, sizeof(uint32_t), compare_samples);
+
+    uint64_t total = 0;
+    for (int i = 0; i < s->num_samples; i++) {
+        total += sorted[i];
+        int bucket = 0;
+        while (bucket < PROFILER_HISTOGRAM_BUCKETS - 1 && sorted[i] >= (1u << bucket)) {
+            bucket++;
+        }
+        stats->histogram[bucket]++;
+    }
+    stats->samples = s->num_samples;
+    stats->mean = (int) (total / s->num_samples);
+    stats->median = sorted[(s->num_samples - 1) / 2];
+    stats->p99 = sorted[(s->num_samples - 1) * 99 / 100];
+    stats->max = sorted[s->num_samples - 1];
+}
+
+void profiler_get_section_name(profiler_section section, char *name, int length)
+{
+    if (section < PROFILER_SECTION_MONTH) {
+        snprintf(name, length, "tick %d", section - PROFILER_SECTION_TICK_SLOT);
+    } else if (section == PROFILER_SECTION_MONTH) {
+        snprintf(name, length, "month");
+    } else if (section == PROFILER_SECTION_YEAR) {
+        snprintf(name, length, "year");
+    } else if (section == PROFILER_SECTION_FIGURES) {
+        snprintf(name, length, "figures");
+    } else if (section < PROFILER_SECTION_DRAW) {
+        snprintf(name, length, "figure %d", section - PROFILER_SECTION_FIGURE_TYPE);
+    } else {
+        snprintf(name, length, "draw");
+    }
+}
+
+int profiler_write_csv(const char *filename)
+{
+    FILE *fp = file_open(filename, "w");
+    if (!fp) {
+        return 0;
+    }
+    fprintf(fp, "section,samples,mean_us,median_us,p99_us,max_us");
+    for (int i = 0; i < PROFILER_HISTOGRAM_BUCKETS - 1; i++) {
+        fprintf(fp, ",below_%uus", 1u << i);
+    }
+    fprintf(fp, ",%uus_or_more", 1u << (PROFILER_HISTOGRAM_BUCKETS - 2));
+    fprintf(fp, "\n");
+    for (int i = 0; i < PROFILER_SECTION_MAX; i++) {
+        profiler_stats stats;
+        profiler_get_stats(i, &stats);
+        if (!stats.samples) {
+            continue;
+        }
+        char name[32];
+        profiler_get_section_name(i, name, sizeof(name));
+        fprintf(fp, "%s,%d,%d,%d,%d,%d", name, stats.samples, stats.mean, stats.median, stats.p99, stats.max);
+        for (int b = 0; b < PROFILER_HISTOGRAM_BUCKETS; b++) {
+            fprintf(fp, ",%d", stats.histogram[b]);
+        }
+        fprintf(fp, "\n");
+    }
+    file_close(fp);
+    return 1;
+}
+
+#endif // DRAW_FPS
@@ -0,0 +1,94 @@
+#ifndef GAME_PROFILER_H
+#define GAME_PROFILER_H
+
+#include "figure/type.h"
+
+#include <stdint.h>
+
+/**
+ * @file
+ * Tick profiler. Only active when building with DRAW_FPS, otherwise the macros compile to nothing.
+ */
+
+#define PROFILER_HISTOGRAM_BUCKETS 16
+
+typedef enum {
+    PROFILER_SECTION_TICK_SLOT = 0, // one section for every advance_tick() slot
+    PROFILER_SECTION_MONTH = 50,
+    PROFILER_SECTION_YEAR = 51,
+    PROFILER_SECTION_FIGURES = 52,
+    PROFILER_SECTION_FIGURE_TYPE = 53, // one section for every figure type
+    PROFILER_SECTION_DRAW = PROFILER_SECTION_FIGURE_TYPE + FIGURE_TYPE_MAX,
+    PROFILER_SECTION_MAX
+} profiler_section;
+
+typedef struct {
+    int samples;
+    int mean;
+    int median;
+    int p99;
+    int max;
+    int histogram[PROFILER_HISTOGRAM_BUCKETS]; // bucket n counts samples from 2^(n-1) to below 2^n microseconds,
+                                               // the last bucket counts all longer samples
+} profiler_stats;
+
+#ifdef DRAW_FPS
+#define PROFILER_START(timer) uint64_t timer = profiler_start()
+#define PROFILER_STOP(section, timer) profiler_stop(section, timer)
+#define PROFILER_ADD(section, timer) profiler_add(section, timer)
+#define PROFILER_COMMIT() profiler_commit()
+#else
+#define PROFILER_START(timer)
+#define PROFILER_STOP(section, timer)
+#define PROFILER_ADD(section, timer)
+#define PROFILER_COMMIT()
+#endif
+
+/**
+ * Starts timing a section
+ * @return Timer to pass to profiler_stop or profiler_add
+ */
+uint64_t profiler_start(void);
+
+/**
+ * Records the time since the timer was started as a new sample of the section
+ * @param section Section to record
+ * @param timer Timer returned by profiler_start
+ */
+void profiler_stop(profiler_section section, uint64_t timer);
+
+/**
+ * Adds the time since the timer was started to the pending sample of the section
+ * @param section Section to add to
+ * @param timer Timer returned by profiler_start
+ */
+void profiler_add(profiler_section section, uint64_t timer);
+
+/**
+ * Records the pending samples of all sections that were added to since the last commit
+ */
+void profiler_commit(void);
+
+/**
+ * Gets the statistics of the last samples of a section
+ * @param section Section
+ * @param stats Statistics, in microseconds
+ */
+void profiler_get_stats(profiler_section section, profiler_stats *stats);
+
+/**
+ * Gets a readable name for a section
+ * @param section Section
+ * @param name Buffer for the name
+ * @param length Length of the buffer
+ */
+void profiler_get_section_name(profiler_section section, char *name, int length);
+
+/**
+ * Writes the statistics of all sections to a CSV file
+ * @param filename File to write
+ * @return 1 on success, 0 on failure
+ */
+int profiler_write_csv(const char *filename);
+
+#endif // GAME_PROFILER_H
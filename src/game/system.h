@@ -4,6 +4,8 @@
 #include "graphics/color.h"
 #include "input/keys.h"
 
+#include <stdint.h>
+
 /**
  * @file
  * Functions that should implemented by the underlying system
@@ -15,6 +17,12 @@
  */
 const char *system_version(void);
 
+/**
+ * Gets a high resolution timestamp, for profiling
+ * @return Timestamp in microseconds
+ */
+uint64_t system_get_microseconds(void);
+
 /**
  * Resize window
  * @param width New width
@@ -37,6 +37,7 @@
 #include "figure/formation.h"
 #include "figuretype/crime.h"
 #include "game/file.h"
+#include "game/profiler.h"
 #include "game/settings.h"
 #include "game/time.h"
 #include "game/tutorial.h"
@@ -60,6 +61,24 @@
 #include "sound/music.h"
 #include "widget/minimap.h"
 
+#define NUM_IDLE_TICKS 8
+
+static const int IDLE_TICKS[NUM_IDLE_TICKS] = { 0, 10, 11, 13, 14, 15, 26, 41 };
+
+static void prepare_month_change(int tick)
+{
+    // only on the last day of the month, so the prepared work is unlikely to be invalidated
+    if (game_time_day() != 15) {
+        return;
+    }
+    for (int i = 0; i < NUM_IDLE_TICKS; i++) {
+        if (IDLE_TICKS[i] == tick) {
+            map_tiles_prepare_water(i, NUM_IDLE_TICKS);
+            return;
+        }
+    }
+}
+
 static void advance_year(void)
 {
     game_undo_disable();
@@ -100,7 +119,9 @@ static void advance_month(void)
     city_message_sort_and_compact();
 
     if (game_time_advance_month()) {
+        PROFILER_START(year_timer);
         advance_year();
+        PROFILER_STOP(PROFILER_SECTION_YEAR, year_timer);
         new_year = 1;
     } else {
         city_ratings_update(0,1);
@@ -111,18 +132,25 @@ static void advance_month(void)
     city_games_decrement_month_counts();
     city_gods_update_blessings();
     tutorial_on_month_tick();
+    const char *autosaves[2];
+    int num_autosaves = 0;
     if (setting_monthly_autosave()) {
-        game_file_write_saved_game("autosave.svx");
+        autosaves[num_autosaves++] = "autosave.svx";
     }
     if (new_year && config_get(CONFIG_GP_CH_YEARLY_AUTOSAVE)) {
-        game_file_write_saved_game("autosave-year.svx");
+        autosaves[num_autosaves++] = "autosave-year.svx";
+    }
+    if (num_autosaves) {
+        game_file_write_saved_game_in_background(autosaves, num_autosaves);
     }
 }
 
 static void advance_day(void)
 {
     if (game_time_advance_day()) {
+        PROFILER_START(month_timer);
         advance_month();
+        PROFILER_STOP(PROFILER_SECTION_MONTH, month_timer);
     }
     if (game_time_day() == 0 || game_time_day() == 8) {
         city_sentiment_update();
@@ -135,13 +163,15 @@ static void advance_day(void)
 
 static void advance_tick(void)
 {
-    // NB: these ticks are noop:
+    // NB: these ticks are noop, apart from preparing the month change:
     // 0, 10, 11, 13, 14, 15, 26, 41
     // max is 49
-    switch (game_time_tick()) {
+    int tick = game_time_tick();
+    PROFILER_START(tick_timer);
+    switch (tick) {
         case 1: city_gods_calculate_moods(1); break;
         case 2: sound_music_update(0); break;
-        case 3: widget_minimap_invalidate(); break;
+        case 3: widget_minimap_update(); break;
         case 4: city_emperor_update(); break;
         case 5: formation_update_all(0); break;
         case 6: map_natives_check_land(); break;
@@ -162,7 +192,7 @@ static void advance_tick(void)
         case 27: map_water_supply_update_reservoir_fountain(); break;
         case 28: map_water_supply_update_houses(); break;
         case 29: formation_update_all(1); break;
-        case 30: widget_minimap_invalidate(); break;
+        case 30: widget_minimap_update(); break;
         case 31: building_figure_generate(); break;
         case 32: city_trade_update(); break;
         case 33: building_count_update(); city_culture_update_coverage(); break;
@@ -181,7 +211,11 @@ static void advance_tick(void)
         case 47: city_games_decrement_duration(); break;
         case 48: house_service_decay_tax_collector(); break;
         case 49: city_culture_calculate(); break;
+        case 0: case 10: case 11: case 13: case 14: case 15: case 26: case 41:
+            prepare_month_change(tick);
+            break;
     }
+    PROFILER_STOP(PROFILER_SECTION_TICK_SLOT + tick, tick_timer);
     if (game_time_advance_tick()) {
         advance_day();
     }
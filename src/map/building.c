@@ -2,9 +2,10 @@
 
 #include "building/building.h"
 #include "core/config.h"
+#include "map/dirty.h"
 #include "map/grid.h"
 
-static grid_u16 buildings_grid;
+static grid_u32 buildings_grid;
 static grid_u8 damage_grid;
 static grid_u8 rubble_type_grid;
 static grid_u8 highlight_grid;
@@ -16,7 +17,10 @@ int map_building_at(int grid_offset)
 
 void map_building_set(int grid_offset, int building_id)
 {
-    buildings_grid.items[grid_offset] = building_id;
+    if (buildings_grid.items[grid_offset] != building_id) {
+        buildings_grid.items[grid_offset] = building_id;
+        map_dirty_mark_tile(grid_offset);
+    }
 }
 
 void map_building_damage_clear(int grid_offset)
@@ -61,9 +65,10 @@ void map_set_rubble_building_type(int grid_offset, building_type type)
 
 void map_building_clear(void)
 {
-    map_grid_clear_u16(buildings_grid.items);
+    map_grid_clear_u32(buildings_grid.items);
     map_grid_clear_u8(damage_grid.items);
     map_grid_clear_u8(rubble_type_grid.items);
+    map_dirty_mark_all();
 }
 
 void map_clear_highlights(void)
@@ -73,14 +78,19 @@ void map_clear_highlights(void)
 
 void map_building_save_state(buffer *buildings, buffer *damage)
 {
-    map_grid_save_state_u16(buildings_grid.items, buildings);
+    map_grid_save_state_u32(buildings_grid.items, buildings);
     map_grid_save_state_u8(damage_grid.items, damage);
 }
 
-void map_building_load_state(buffer *buildings, buffer *damage)
+void map_building_load_state(buffer *buildings, buffer *damage, int expanded_ids)
 {
-    map_grid_load_state_u16(buildings_grid.items, buildings);
+    if (expanded_ids) {
+        map_grid_load_state_u32(buildings_grid.items, buildings);
+    } else {
+        map_grid_load_state_u16_to_u32(buildings_grid.items, buildings);
+    }
     map_grid_load_state_u8(damage_grid.items, damage);
+    map_dirty_mark_all();
 }
 
 int map_building_is_reservoir(int x, int y)
@@ -38,7 +38,7 @@ void map_clear_highlights(void);
 
 void map_building_save_state(buffer *buildings, buffer *damage);
 
-void map_building_load_state(buffer *buildings, buffer *damage);
+void map_building_load_state(buffer *buildings, buffer *damage, int expanded_ids);
 
 int map_building_is_reservoir(int x, int y);
 
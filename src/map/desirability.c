@@ -3,18 +3,61 @@
 #include "building/building.h"
 #include "building/model.h"
 #include "building/monument.h"
+#include "core/array.h"
 #include "core/calc.h"
+#include "core/config.h"
 #include "map/data.h"
 #include "map/grid.h"
 #include "map/property.h"
 #include "map/ring.h"
 #include "map/terrain.h"
 
+#include <string.h>
+
+#define SOURCE_ARRAY_SIZE_STEP 1000
+
+typedef enum {
+    TERRAIN_SOURCE_NONE = 0,
+    TERRAIN_SOURCE_PLAZA = 1,
+    TERRAIN_SOURCE_EARTHQUAKE = 2,
+    TERRAIN_SOURCE_GARDEN = 3,
+    TERRAIN_SOURCE_RUBBLE = 4
+} terrain_source;
+
+typedef struct {
+    int x;
+    int y;
+    int size;
+    int value;
+    int step;
+    int step_size;
+    int range;
+} desirability_source;
+
 static grid_i8 desirability_grid;
 
+static struct {
+    int is_valid;
+    int is_accumulating;
+    int accumulated[GRID_SIZE * GRID_SIZE];
+    grid_u8 terrain_sources;
+    array(desirability_source) building_sources;
+} incremental;
+
 void map_desirability_clear(void)
 {
     map_grid_clear_i8(desirability_grid.items);
+    incremental.is_valid = 0;
+}
+
+static void change_desirability(int grid_offset, int desirability)
+{
+    if (incremental.is_accumulating) {
+        incremental.accumulated[grid_offset] += desirability;
+        desirability_grid.items[grid_offset] = calc_bound(incremental.accumulated[grid_offset], -100, 100);
+    } else {
+        desirability_grid.items[grid_offset] = calc_bound(desirability_grid.items[grid_offset] + desirability, -100, 100);
+    }
 }
 
 static void add_desirability_at_distance(int x, int y, int size, int distance, int desirability)
@@ -34,15 +77,13 @@ static void add_desirability_at_distance(int x, int y, int size, int distance, i
         for (int i = start; i < end; i++) {
             const ring_tile *tile = map_ring_tile(i);
             if (map_ring_is_inside_map(x + tile->x, y + tile->y)) {
-                desirability_grid.items[base_offset + tile->grid_offset] =
-                    calc_bound(desirability_grid.items[base_offset + tile->grid_offset] + desirability, -100, 100);
+                change_desirability(base_offset + tile->grid_offset, desirability);
             }
         }
     } else {
         for (int i = start; i < end; i++) {
             const ring_tile *tile = map_ring_tile(i);
-            desirability_grid.items[base_offset + tile->grid_offset] =
-                calc_bound(desirability_grid.items[base_offset + tile->grid_offset] + desirability, -100, 100);
+            change_desirability(base_offset + tile->grid_offset, desirability);
         }
     }
 }
@@ -68,100 +109,234 @@ static void add_to_terrain(int x, int y, int size, int desirability, int step, i
     }
 }
 
+static void add_source(const desirability_source *source)
+{
+    add_to_terrain(source->x, source->y, source->size,
+        source->value, source->step, source->step_size, source->range);
+}
+
+static void remove_source(const desirability_source *source)
+{
+    add_to_terrain(source->x, source->y, source->size,
+        -source->value, source->step, -source->step_size, source->range);
+}
+
+static void set_model_source(desirability_source *source, int x, int y, const model_building *model)
+{
+    source->x = x;
+    source->y = y;
+    source->size = 1;
+    source->value = model->desirability_value;
+    source->step = model->desirability_step;
+    source->step_size = model->desirability_step_size;
+    source->range = model->desirability_range;
+}
+
+static void get_building_source(building *b, int venus_module2, int venus_gt, desirability_source *source)
+{
+    memset(source, 0, sizeof(desirability_source));
+    if (b->state != BUILDING_STATE_IN_USE) {
+        return;
+    }
+    const model_building *model = model_get_building(b->type);
+    int value = model->desirability_value;
+    int step = model->desirability_step;
+    int step_size = model->desirability_step_size;
+    int range = model->desirability_range;
+
+    // Venus Module 2 House Desirability Bonus
+    if (building_is_house(b->type) && b->data.house.temple_venus && venus_module2) {
+        if (b->subtype.house_level >= HOUSE_SMALL_VILLA) {
+            value += 4;
+            range += 1;
+        } else {
+            value += 2;
+        }
+    }
+
+    if (building_monument_is_monument(b) && b->data.monument.phase != MONUMENT_FINISHED) {
+        value = 0;
+        step = 0;
+        step_size = 0;
+        range = 0;
+    }
+
+    // Venus GT Base Bonus
+    if (building_is_statue_garden_temple(b->type) && venus_gt) {
+        int value_bonus = ((value / 4) > 1) ? (value / 4) : 1;
+        value += value_bonus;
+        step += 1;
+        range += 1;
+    }
+
+    if (b->size <= 0 || range <= 0) {
+        // nothing is added to the terrain
+        return;
+    }
+    source->x = b->x;
+    source->y = b->y;
+    source->size = b->size;
+    source->value = value;
+    source->step = step;
+    source->step_size = step_size;
+    source->range = range;
+}
+
+static terrain_source get_terrain_source(int grid_offset)
+{
+    int terrain = map_terrain_get(grid_offset);
+    if (map_property_is_plaza_or_earthquake(grid_offset)) {
+        if (terrain & TERRAIN_ROAD) {
+            return TERRAIN_SOURCE_PLAZA;
+        } else if (terrain & TERRAIN_ROCK) {
+            // earthquake fault line: slight negative
+            return TERRAIN_SOURCE_EARTHQUAKE;
+        } else {
+            // invalid plaza/earthquake flag
+            map_property_clear_plaza_or_earthquake(grid_offset);
+            return TERRAIN_SOURCE_NONE;
+        }
+    } else if (terrain & TERRAIN_GARDEN) {
+        return TERRAIN_SOURCE_GARDEN;
+    } else if (terrain & TERRAIN_RUBBLE) {
+        return TERRAIN_SOURCE_RUBBLE;
+    }
+    return TERRAIN_SOURCE_NONE;
+}
+
+static int get_terrain_desirability_source(terrain_source type, int x, int y, desirability_source *source)
+{
+    switch (type) {
+        case TERRAIN_SOURCE_PLAZA:
+            set_model_source(source, x, y, model_get_building(BUILDING_PLAZA));
+            return 1;
+        case TERRAIN_SOURCE_EARTHQUAKE:
+            set_model_source(source, x, y, model_get_building(BUILDING_HOUSE_VACANT_LOT));
+            return 1;
+        case TERRAIN_SOURCE_GARDEN:
+            set_model_source(source, x, y, model_get_building(BUILDING_GARDENS));
+            return 1;
+        case TERRAIN_SOURCE_RUBBLE:
+            source->x = x;
+            source->y = y;
+            source->size = 1;
+            source->value = -2;
+            source->step = 1;
+            source->step_size = 1;
+            source->range = 2;
+            return 1;
+        default:
+            return 0;
+    }
+}
+
 static void update_buildings(void)
 {
-    int value;
-    int value_bonus;
-    int step;
-    int step_size;
-    int range;
     int venus_module2 = building_monument_gt_module_is_active(VENUS_MODULE_2_DESIRABILITY_ENTERTAINMENT);
     int venus_gt = building_monument_working(BUILDING_GRAND_TEMPLE_VENUS);
-    for (int i = 1; i < building_count(); i++) {
-        building *b = building_get(i);
-        if (b->state == BUILDING_STATE_IN_USE) {
-
-            const model_building *model = model_get_building(b->type);
-            value = model->desirability_value;
-            step = model->desirability_step;
-            step_size = model->desirability_step_size;
-            range = model->desirability_range;
-
-            // Venus Module 2 House Desirability Bonus
-            if (building_is_house(b->type) && b->data.house.temple_venus && venus_module2) {
-                if (b->subtype.house_level >= HOUSE_SMALL_VILLA) {
-                    value += 4;
-                    range += 1;
-                } else {
-                    value += 2;
-                }
-            }
+    for (building *b = building_first_in_category(BUILDING_CATEGORY_ALL); b;
+         b = building_next_in_category(BUILDING_CATEGORY_ALL, b)) {
+        desirability_source source;
+        get_building_source(b, venus_module2, venus_gt, &source);
+        add_source(&source);
+    }
+}
 
-            if (building_monument_is_monument(b) && b->data.monument.phase != MONUMENT_FINISHED) {
-                value = 0;
-                step = 0;
-                step_size = 0;
-                range = 0;
+static void update_terrain(void)
+{
+    int grid_offset = map_data.start_offset;
+    for (int y = 0; y < map_data.height; y++, grid_offset += map_data.border_size) {
+        for (int x = 0; x < map_data.width; x++, grid_offset++) {
+            desirability_source source;
+            if (get_terrain_desirability_source(get_terrain_source(grid_offset), x, y, &source)) {
+                add_source(&source);
             }
+        }
+    }
+}
 
-            // Venus GT Base Bonus
-            if (building_is_statue_garden_temple(b->type) && venus_gt) {
-                value_bonus = ((value / 4) > 1) ? (value / 4) : 1;
-                value += value_bonus;
-                step += 1;
-                range += 1;
-            }
+static int start_incremental_update(void)
+{
+    if (!array_init(incremental.building_sources, SOURCE_ARRAY_SIZE_STEP, 0, 0)) {
+        return 0;
+    }
+    map_grid_clear_i8(desirability_grid.items);
+    memset(incremental.accumulated, 0, sizeof(incremental.accumulated));
+    map_grid_clear_u8(incremental.terrain_sources.items);
+    incremental.is_valid = 1;
+    return 1;
+}
 
-            add_to_terrain(
-                b->x, b->y, b->size,
-                value,
-                step,
-                step_size,
-                range);
+static int update_building_sources_incrementally(void)
+{
+    int venus_module2 = building_monument_gt_module_is_active(VENUS_MODULE_2_DESIRABILITY_ENTERTAINMENT);
+    int venus_gt = building_monument_working(BUILDING_GRAND_TEMPLE_VENUS);
+    while (incremental.building_sources.size < building_count()) {
+        if (!array_advance(incremental.building_sources)) {
+            return 0;
+        }
+    }
+    for (int i = 1; i < incremental.building_sources.size; i++) {
+        desirability_source *applied = array_item(incremental.building_sources, i);
+        desirability_source source;
+        if (i < building_count()) {
+            get_building_source(building_get(i), venus_module2, venus_gt, &source);
+        } else {
+            memset(&source, 0, sizeof(desirability_source));
+        }
+        if (memcmp(applied, &source, sizeof(desirability_source)) != 0) {
+            remove_source(applied);
+            add_source(&source);
+            *applied = source;
         }
     }
+    return 1;
 }
 
-static void update_terrain(void)
+static void update_terrain_sources_incrementally(void)
 {
     int grid_offset = map_data.start_offset;
     for (int y = 0; y < map_data.height; y++, grid_offset += map_data.border_size) {
         for (int x = 0; x < map_data.width; x++, grid_offset++) {
-            int terrain = map_terrain_get(grid_offset);
-            if (map_property_is_plaza_or_earthquake(grid_offset)) {
-                int type;
-                if (terrain & TERRAIN_ROAD) {
-                    type = BUILDING_PLAZA;
-                } else if (terrain & TERRAIN_ROCK) {
-                    // earthquake fault line: slight negative
-                    type = BUILDING_HOUSE_VACANT_LOT;
-                } else {
-                    // invalid plaza/earthquake flag
-                    map_property_clear_plaza_or_earthquake(grid_offset);
-                    continue;
-                }
-                const model_building *model = model_get_building(type);
-                add_to_terrain(x, y, 1,
-                    model->desirability_value,
-                    model->desirability_step,
-                    model->desirability_step_size,
-                    model->desirability_range);
-            } else if (terrain & TERRAIN_GARDEN) {
-                const model_building *model = model_get_building(BUILDING_GARDENS);
-                add_to_terrain(x, y, 1,
-                    model->desirability_value,
-                    model->desirability_step,
-                    model->desirability_step_size,
-                    model->desirability_range);
-            } else if (terrain & TERRAIN_RUBBLE) {
-                add_to_terrain(x, y, 1, -2, 1, 1, 2);
+            terrain_source type = get_terrain_source(grid_offset);
+            terrain_source applied_type = incremental.terrain_sources.items[grid_offset];
+            if (type == applied_type) {
+                continue;
+            }
+            desirability_source source;
+            if (get_terrain_desirability_source(applied_type, x, y, &source)) {
+                remove_source(&source);
+            }
+            if (get_terrain_desirability_source(type, x, y, &source)) {
+                add_source(&source);
             }
+            incremental.terrain_sources.items[grid_offset] = type;
         }
     }
 }
 
+static int update_incrementally(void)
+{
+    if (!incremental.is_valid && !start_incremental_update()) {
+        return 0;
+    }
+    incremental.is_accumulating = 1;
+    int success = update_building_sources_incrementally();
+    if (success) {
+        update_terrain_sources_incrementally();
+    }
+    incremental.is_accumulating = 0;
+    if (!success) {
+        incremental.is_valid = 0;
+    }
+    return success;
+}
+
 void map_desirability_update(void)
 {
+    if (config_get(CONFIG_GP_CH_INCREMENTAL_DESIRABILITY) && update_incrementally()) {
+        return;
+    }
     map_desirability_clear();
     update_buildings();
     update_terrain();
@@ -197,4 +372,7 @@ void map_desirability_save_state(buffer *buf)
 void map_desirability_load_state(buffer *buf)
 {
     map_grid_load_state_i8(desirability_grid.items, buf);
+    // the sums belong to the previous city: rebuild them on the next update.
+    // Undo needs no reset, as every update compares all buildings and tiles to what was applied
+    incremental.is_valid = 0;
 }
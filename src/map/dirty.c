@@ -0,0 +1,64 @@
+#include "dirty.h"
+
+#include "map/grid.h"
+
+#include <stdint.h>
+
+#define CHUNKS_PER_ROW ((GRID_SIZE + MAP_DIRTY_CHUNK_SIZE - 1) / MAP_DIRTY_CHUNK_SIZE)
+#define ALL_VIEWS ((1 << MAP_DIRTY_VIEW_MAX) - 1)
+
+static struct {
+    uint8_t chunks[CHUNKS_PER_ROW * CHUNKS_PER_ROW];
+    int has_changes;
+    int all_changed;
+} data = { .all_changed = ALL_VIEWS };
+
+void map_dirty_mark_tile(int grid_offset)
+{
+    int x = grid_offset % GRID_SIZE;
+    int y = grid_offset / GRID_SIZE;
+    data.chunks[(y / MAP_DIRTY_CHUNK_SIZE) * CHUNKS_PER_ROW + x / MAP_DIRTY_CHUNK_SIZE] = ALL_VIEWS;
+    data.has_changes = ALL_VIEWS;
+}
+
+void map_dirty_mark_all(void)
+{
+    data.all_changed = ALL_VIEWS;
+}
+
+void map_dirty_clear(map_dirty_view view)
+{
+    uint8_t mask = ~(1 << view);
+    for (int i = 0; i < CHUNKS_PER_ROW * CHUNKS_PER_ROW; i++) {
+        data.chunks[i] &= mask;
+    }
+    data.has_changes &= mask;
+    data.all_changed &= mask;
+}
+
+int map_dirty_take_changes(map_dirty_view view, map_dirty_callback *callback)
+{
+    int bit = 1 << view;
+    if (data.all_changed & bit) {
+        map_dirty_clear(view);
+        return 0;
+    }
+    if (!(data.has_changes & bit)) {
+        return 1;
+    }
+    for (int y = 0; y < CHUNKS_PER_ROW; y++) {
+        for (int x = 0; x < CHUNKS_PER_ROW; x++) {
+            if (!(data.chunks[y * CHUNKS_PER_ROW + x] & bit)) {
+                continue;
+            }
+            data.chunks[y * CHUNKS_PER_ROW + x] &= ~bit;
+            int x_min = x * MAP_DIRTY_CHUNK_SIZE;
+            int y_min = y * MAP_DIRTY_CHUNK_SIZE;
+            int x_max = x_min + MAP_DIRTY_CHUNK_SIZE - 1;
+            int y_max = y_min + MAP_DIRTY_CHUNK_SIZE - 1;
+            callback(x_min, y_min, x_max < GRID_SIZE ? x_max : GRID_SIZE - 1, y_max < GRID_SIZE ? y_max : GRID_SIZE - 1);
+        }
+    }
+    data.has_changes &= ~bit;
+    return 1;
+}
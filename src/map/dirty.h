@@ -0,0 +1,46 @@
+#ifndef MAP_DIRTY_H
+#define MAP_DIRTY_H
+
+/**
+ * @file
+ * Keeps track of the map tiles whose terrain, images or buildings changed, in square chunks of tiles,
+ * so views of the map only have to redraw the changed parts. Every view keeps its own set of changes.
+ */
+
+#define MAP_DIRTY_CHUNK_SIZE 8
+
+typedef enum {
+    MAP_DIRTY_VIEW_MINIMAP = 0,
+    MAP_DIRTY_VIEW_CITY = 1,
+    MAP_DIRTY_VIEW_MAX
+} map_dirty_view;
+
+typedef void (map_dirty_callback)(int x_min, int y_min, int x_max, int y_max);
+
+/**
+ * Marks the chunk containing the tile as changed for all views
+ * @param grid_offset Tile that changed
+ */
+void map_dirty_mark_tile(int grid_offset);
+
+/**
+ * Marks the whole map as changed for all views
+ */
+void map_dirty_mark_all(void);
+
+/**
+ * Forgets all changes of a view, to be used after the view redrew everything
+ * @param view View to clear
+ */
+void map_dirty_clear(map_dirty_view view);
+
+/**
+ * Calls the callback for the grid area of every chunk that changed for the view and clears its changes
+ * @param view View to get the changes for
+ * @param callback Function to call for every changed chunk
+ * @return 1 if the changed chunks were passed to the callback,
+ *         0 if the whole map changed, in which case the callback is not called
+ */
+int map_dirty_take_changes(map_dirty_view view, map_dirty_callback *callback);
+
+#endif // MAP_DIRTY_H
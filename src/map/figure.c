@@ -1,8 +1,89 @@
 #include "figure.h"
 
+#include "core/calc.h"
 #include "map/grid.h"
 
-static grid_u16 figures;
+#define AREA_SIZE 8
+#define AREAS_PER_ROW ((GRID_SIZE + AREA_SIZE - 1) / AREA_SIZE)
+#define MAX_AREAS (AREAS_PER_ROW * AREAS_PER_ROW)
+#define NUM_FIGURE_GROUPS 4
+
+static grid_u32 figures;
+
+static struct {
+    int valid;
+    int first_figure_id[NUM_FIGURE_GROUPS][MAX_AREAS];
+} area;
+
+static int get_group_index(const figure *f)
+{
+    if (figure_is_enemy(f) || f->type == FIGURE_RIOTER || f->type == FIGURE_INDIGENOUS_NATIVE) {
+        return 0;
+    } else if (figure_is_legion(f)) {
+        return 1;
+    } else if (figure_is_herd(f)) {
+        return 2;
+    } else {
+        return 3;
+    }
+}
+
+static void area_remove(figure *f)
+{
+    if (!f->area_index) {
+        return;
+    }
+    if (f->previous_figure_id_in_area) {
+        figure_get(f->previous_figure_id_in_area)->next_figure_id_in_area = f->next_figure_id_in_area;
+    } else {
+        area.first_figure_id[f->area_group][f->area_index - 1] = f->next_figure_id_in_area;
+    }
+    if (f->next_figure_id_in_area) {
+        figure_get(f->next_figure_id_in_area)->previous_figure_id_in_area = f->previous_figure_id_in_area;
+    }
+    f->next_figure_id_in_area = 0;
+    f->previous_figure_id_in_area = 0;
+    f->area_index = 0;
+}
+
+static void area_add(figure *f)
+{
+    area_remove(f);
+    int index = (map_grid_offset_to_y(f->grid_offset) / AREA_SIZE) * AREAS_PER_ROW +
+        map_grid_offset_to_x(f->grid_offset) / AREA_SIZE;
+    f->area_group = get_group_index(f);
+    f->area_index = index + 1;
+    f->previous_figure_id_in_area = 0;
+    f->next_figure_id_in_area = area.first_figure_id[f->area_group][index];
+    if (f->next_figure_id_in_area) {
+        figure_get(f->next_figure_id_in_area)->previous_figure_id_in_area = f->id;
+    }
+    area.first_figure_id[f->area_group][index] = f->id;
+}
+
+static void area_rebuild(void)
+{
+    for (int i = 1; i < figure_count(); i++) {
+        figure *f = figure_get(i);
+        f->area_index = 0;
+        f->next_figure_id_in_area = 0;
+        f->previous_figure_id_in_area = 0;
+    }
+    for (int g = 0; g < NUM_FIGURE_GROUPS; g++) {
+        for (int i = 0; i < MAX_AREAS; i++) {
+            area.first_figure_id[g][i] = 0;
+        }
+    }
+    for (int grid_offset = 0; grid_offset < GRID_SIZE * GRID_SIZE; grid_offset++) {
+        int figure_id = figures.items[grid_offset];
+        while (figure_id) {
+            figure *f = figure_get(figure_id);
+            area_add(f);
+            figure_id = f->next_figure_id_on_same_tile;
+        }
+    }
+    area.valid = 1;
+}
 
 int map_has_figure_at(int grid_offset)
 {
@@ -36,6 +117,9 @@ void map_figure_add(figure *f)
     } else {
         figures.items[f->grid_offset] = f->id;
     }
+    if (area.valid) {
+        area_add(f);
+    }
 }
 
 void map_figure_update(figure *f)
@@ -60,6 +144,9 @@ void map_figure_update(figure *f)
 
 void map_figure_delete(figure *f)
 {
+    if (area.valid) {
+        area_remove(f);
+    }
     if (!map_grid_is_valid_offset(f->grid_offset) || !figures.items[f->grid_offset]) {
         f->next_figure_id_on_same_tile = 0;
         return;
@@ -93,17 +180,56 @@ int map_figure_foreach_until(int grid_offset, int (*callback)(figure *f))
     return 0;
 }
 
+void map_figure_update_group(figure *f)
+{
+    if (area.valid && f->area_index && f->area_group != get_group_index(f)) {
+        area_add(f);
+    }
+}
+
+void map_figure_foreach_in_area(int x, int y, int radius, int groups, void (*callback)(figure *f))
+{
+    if (!area.valid) {
+        area_rebuild();
+    }
+    int min_x = calc_bound(x - radius, 0, GRID_SIZE - 1) / AREA_SIZE;
+    int max_x = calc_bound(x + radius, 0, GRID_SIZE - 1) / AREA_SIZE;
+    int min_y = calc_bound(y - radius, 0, GRID_SIZE - 1) / AREA_SIZE;
+    int max_y = calc_bound(y + radius, 0, GRID_SIZE - 1) / AREA_SIZE;
+    for (int g = 0; g < NUM_FIGURE_GROUPS; g++) {
+        if (!(groups & (1 << g))) {
+            continue;
+        }
+        for (int area_y = min_y; area_y <= max_y; area_y++) {
+            for (int area_x = min_x; area_x <= max_x; area_x++) {
+                int figure_id = area.first_figure_id[g][area_y * AREAS_PER_ROW + area_x];
+                while (figure_id) {
+                    figure *f = figure_get(figure_id);
+                    callback(f);
+                    figure_id = f->next_figure_id_in_area;
+                }
+            }
+        }
+    }
+}
+
 void map_figure_clear(void)
 {
-    map_grid_clear_u16(figures.items);
+    map_grid_clear_u32(figures.items);
+    area.valid = 0;
 }
 
 void map_figure_save_state(buffer *buf)
 {
-    map_grid_save_state_u16(figures.items, buf);
+    map_grid_save_state_u32(figures.items, buf);
 }
 
-void map_figure_load_state(buffer *buf)
+void map_figure_load_state(buffer *buf, int expanded_ids)
 {
-    map_grid_load_state_u16(figures.items, buf);
+    if (expanded_ids) {
+        map_grid_load_state_u32(figures.items, buf);
+    } else {
+        map_grid_load_state_u16_to_u32(figures.items, buf);
+    }
+    area.valid = 0;
 }
@@ -4,6 +4,14 @@
 #include "core/buffer.h"
 #include "figure/figure.h"
 
+typedef enum {
+    FIGURE_GROUP_HOSTILE = 1, // enemies, rioters and natives
+    FIGURE_GROUP_LEGION = 2,
+    FIGURE_GROUP_HERD = 4,
+    FIGURE_GROUP_OTHER = 8,
+    FIGURE_GROUP_ALL = 15
+} figure_group;
+
 /**
  * Returns the first figure at the given offset
  * @param grid_offset Map offset
@@ -26,6 +34,23 @@ void map_figure_delete(figure *f);
 
 int map_figure_foreach_until(int grid_offset, int (*callback)(figure *f));
 
+/**
+ * Updates the figure's group in the area index after its type has changed
+ * @param f Figure
+ */
+void map_figure_update_group(figure *f);
+
+/**
+ * Calls the callback for every figure of the given groups that may be within the radius.
+ * The figures are taken from coarse map areas, so the callback still has to check the distance.
+ * @param x Center x
+ * @param y Center y
+ * @param radius Maximum distance
+ * @param groups Combination of figure_group flags
+ * @param callback Function to call for each figure
+ */
+void map_figure_foreach_in_area(int x, int y, int radius, int groups, void (*callback)(figure *f));
+
 /**
  * Clears the map
  */
@@ -33,6 +58,6 @@ void map_figure_clear(void);
 
 void map_figure_save_state(buffer *buf);
 
-void map_figure_load_state(buffer *buf);
+void map_figure_load_state(buffer *buf, int expanded_ids);
 
 #endif // MAP_FIGURE_H
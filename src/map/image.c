@@ -5,6 +5,7 @@
 #include "core/image.h"
 #include "core/image_group.h"
 #include "map/building_tiles.h"
+#include "map/dirty.h"
 #include "map/grid.h"
 #include "map/orientation.h"
 #include "map/tiles.h"
@@ -18,6 +19,14 @@ unsigned int map_image_at(int grid_offset)
 }
 
 void map_image_set(int grid_offset, int image_id)
+{
+    if (images.items[grid_offset] != (unsigned int) image_id) {
+        images.items[grid_offset] = image_id;
+        map_dirty_mark_tile(grid_offset);
+    }
+}
+
+void map_image_set_animation_frame(int grid_offset, int image_id)
 {
     images.items[grid_offset] = image_id;
 }
@@ -29,17 +38,20 @@ void map_image_backup(void)
 
 void map_image_restore(void)
 {
-    map_grid_copy_u32(images_backup.items, images.items);
+    for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        map_image_set(i, images_backup.items[i]);
+    }
 }
 
 void map_image_restore_at(int grid_offset)
 {
-    images.items[grid_offset] = images_backup.items[grid_offset];
+    map_image_set(grid_offset, images_backup.items[grid_offset]);
 }
 
 void map_image_clear(void)
 {
     map_grid_clear_u32(images.items);
+    map_dirty_mark_all();
 }
 
 void map_image_init_edges(void)
@@ -47,14 +59,14 @@ void map_image_init_edges(void)
     int width, height;
     map_grid_size(&width, &height);
     for (int x = 1; x < width; x++) {
-        images.items[map_grid_offset(x, height)] = 1;
+        map_image_set(map_grid_offset(x, height), 1);
     }
     for (int y = 1; y < height; y++) {
-        images.items[map_grid_offset(width, y)] = 2;
+        map_image_set(map_grid_offset(width, y), 2);
     }
-    images.items[map_grid_offset(0, height)] = 3;
-    images.items[map_grid_offset(width, 0)] = 4;
-    images.items[map_grid_offset(width, height)] = 5;
+    map_image_set(map_grid_offset(0, height), 3);
+    map_image_set(map_grid_offset(width, 0), 4);
+    map_image_set(map_grid_offset(width, height), 5);
 }
 
 void map_image_update_all(void)
@@ -94,4 +106,5 @@ void map_image_save_state(buffer *buf)
 void map_image_load_state_legacy(buffer *buf)
 {
     map_grid_load_state_u16_to_u32(images.items, buf);
+    map_dirty_mark_all();
 }
@@ -7,6 +7,8 @@ unsigned int map_image_at(int grid_offset);
 
 void map_image_set(int grid_offset, int image_id);
 
+void map_image_set_animation_frame(int grid_offset, int image_id);
+
 void map_image_backup(void);
 
 void map_image_restore(void);
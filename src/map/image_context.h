@@ -15,6 +15,8 @@ void map_image_context_reset_elevation(void);
 const terrain_image *map_image_context_get_elevation(int grid_offset, int elevation);
 const terrain_image *map_image_context_get_earthquake(int grid_offset);
 const terrain_image *map_image_context_get_shore(int grid_offset);
+int map_image_context_find_shore(int grid_offset);
+const terrain_image *map_image_context_get_shore_for_context(int context);
 const terrain_image *map_image_context_get_wall(int grid_offset);
 const terrain_image *map_image_context_get_wall_gatehouse(int grid_offset);
 const terrain_image *map_image_context_get_dirt_road(int grid_offset);
@@ -1,5 +1,6 @@
 #include "property.h"
 
+#include "map/dirty.h"
 #include "map/grid.h"
 #include "map/random.h"
 
@@ -45,14 +46,22 @@ int map_property_is_draw_tile(int grid_offset)
     return edge_grid.items[grid_offset] & EDGE_LEFTMOST_TILE;
 }
 
+static void set_edge(int grid_offset, uint8_t edge)
+{
+    if ((edge_grid.items[grid_offset] ^ edge) & EDGE_LEFTMOST_TILE) {
+        map_dirty_mark_tile(grid_offset);
+    }
+    edge_grid.items[grid_offset] = edge;
+}
+
 void map_property_mark_draw_tile(int grid_offset)
 {
-    edge_grid.items[grid_offset] |= EDGE_LEFTMOST_TILE;
+    set_edge(grid_offset, edge_grid.items[grid_offset] | EDGE_LEFTMOST_TILE);
 }
 
 void map_property_clear_draw_tile(int grid_offset)
 {
-    edge_grid.items[grid_offset] &= ~EDGE_LEFTMOST_TILE;
+    set_edge(grid_offset, edge_grid.items[grid_offset] & ~EDGE_LEFTMOST_TILE);
 }
 
 int map_property_is_native_land(int grid_offset)
@@ -93,16 +102,16 @@ int map_property_is_multi_tile_xy(int grid_offset, int x, int y)
 void map_property_set_multi_tile_xy(int grid_offset, int x, int y, int is_draw_tile)
 {
     if (is_draw_tile) {
-        edge_grid.items[grid_offset] = edge_for(x, y) | EDGE_LEFTMOST_TILE;
+        set_edge(grid_offset, edge_for(x, y) | EDGE_LEFTMOST_TILE);
     } else {
-        edge_grid.items[grid_offset] = edge_for(x, y);
+        set_edge(grid_offset, edge_for(x, y));
     }
 }
 
 void map_property_clear_multi_tile_xy(int grid_offset)
 {
     // only keep native land marker
-    edge_grid.items[grid_offset] &= EDGE_NATIVE_LAND;
+    set_edge(grid_offset, edge_grid.items[grid_offset] & EDGE_NATIVE_LAND);
 }
 
 int map_property_multi_tile_size(int grid_offset)
@@ -119,6 +128,7 @@ int map_property_multi_tile_size(int grid_offset)
 
 void map_property_set_multi_tile_size(int grid_offset, int size)
 {
+    uint8_t old_size = bitfields_grid.items[grid_offset] & BIT_SIZES;
     bitfields_grid.items[grid_offset] &= BIT_NO_SIZES;
     switch (size) {
         case 2: bitfields_grid.items[grid_offset] |= BIT_SIZE2; break;
@@ -128,6 +138,9 @@ void map_property_set_multi_tile_size(int grid_offset, int size)
         case 7: bitfields_grid.items[grid_offset] |= BIT_SIZE7; break;
 
     }
+    if ((bitfields_grid.items[grid_offset] & BIT_SIZES) != old_size) {
+        map_dirty_mark_tile(grid_offset);
+    }
 }
 
 void map_property_init_alternate_terrain(void)
@@ -203,6 +216,7 @@ void map_property_clear(void)
 {
     map_grid_clear_u8(bitfields_grid.items);
     map_grid_clear_u8(edge_grid.items);
+    map_dirty_mark_all();
 }
 
 void map_property_backup(void)
@@ -213,6 +227,12 @@ void map_property_backup(void)
 
 void map_property_restore(void)
 {
+    for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        if (((bitfields_grid.items[i] ^ bitfields_backup.items[i]) & BIT_SIZES) ||
+            ((edge_grid.items[i] ^ edge_backup.items[i]) & EDGE_LEFTMOST_TILE)) {
+            map_dirty_mark_tile(i);
+        }
+    }
     map_grid_copy_u8(bitfields_backup.items, bitfields_grid.items);
     map_grid_copy_u8(edge_backup.items, edge_grid.items);
 }
@@ -227,4 +247,5 @@ void map_property_load_state(buffer *bitfields, buffer *edge)
 {
     map_grid_load_state_u8(bitfields_grid.items, bitfields);
     map_grid_load_state_u8(edge_grid.items, edge);
+    map_dirty_mark_all();
 }
@@ -7,6 +7,7 @@
 #include "map/grid.h"
 #include "map/road_aqueduct.h"
 #include "map/routing_data.h"
+#include "map/routing_hierarchy.h"
 #include "map/terrain.h"
 
 #include <stdlib.h>
@@ -29,6 +30,8 @@ static const int ROUTE_OFFSETS_Y[] = { -1, 0, 1,  0, -1, 1,  1, -1 };
 static struct {
     grid_i16 possible;
     grid_i16 determined;
+    grid_u16 generation; // tiles stamped with an older generation count as cleared
+    uint16_t current_generation;
     int dst_x;
     int dst_y;
 } distance;
@@ -36,30 +39,45 @@ static struct {
 static struct {
     int total_routes_calculated;
     int enemy_routes_calculated;
+    int heap_operations;
 } stats;
 
 static struct {
     int head;
     int tail;
     int items[MAX_QUEUE];
+    int heap_index[GRID_SIZE * GRID_SIZE]; // position in items for offsets in the ordered queue
 } queue;
 
 static grid_u8 water_drag;
 
 static struct {
     grid_u8 status;
+    grid_u16 generation;
+    uint16_t current_generation;
     time_millis last_check;
 } fighting_data;
 
 static struct {
     int through_building_id;
+    void (*corridor_callback)(int next_offset, int dist, int remaining_dist);
 } state;
 
+static uint16_t next_generation(uint16_t generation, grid_u16 *stamps)
+{
+    if (++generation == 0) {
+        map_grid_clear_u16(stamps->items);
+        generation = 1;
+    }
+    return generation;
+}
+
 static void reset_fighting_status(void)
 {
     time_millis current_time = time_get_millis();
     if (current_time != fighting_data.last_check) {
-        map_grid_clear_u8(fighting_data.status.items);
+        fighting_data.current_generation =
+            next_generation(fighting_data.current_generation, &fighting_data.generation);
         fighting_data.last_check = current_time;
     }
 }
@@ -67,15 +85,36 @@ static void reset_fighting_status(void)
 static void clear_data(void)
 {
     reset_fighting_status();
-    map_grid_clear_i16(distance.possible.items);
-    map_grid_clear_i16(distance.determined.items);
+    distance.current_generation = next_generation(distance.current_generation, &distance.generation);
     queue.head = 0;
     queue.tail = 0;
 }
 
+static inline void touch_tile(int grid_offset)
+{
+    if (distance.generation.items[grid_offset] != distance.current_generation) {
+        distance.generation.items[grid_offset] = distance.current_generation;
+        distance.possible.items[grid_offset] = 0;
+        distance.determined.items[grid_offset] = 0;
+        water_drag.items[grid_offset] = 0;
+    }
+}
+
+static inline int determined_distance(int grid_offset)
+{
+    return distance.generation.items[grid_offset] == distance.current_generation ?
+        distance.determined.items[grid_offset] : 0;
+}
+
+static inline void set_determined_distance(int grid_offset, int dist)
+{
+    touch_tile(grid_offset);
+    distance.determined.items[grid_offset] = dist;
+}
+
 static inline void enqueue(int next_offset, int dist)
 {
-    distance.determined.items[next_offset] = dist;
+    set_determined_distance(next_offset, dist);
     queue.items[queue.tail++] = next_offset;
     if (queue.tail >= MAX_QUEUE) {
         queue.tail = 0;
@@ -96,11 +135,17 @@ static inline int ordered_queue_parent(int index)
     return (index - 1) / 2;
 }
 
+static inline void ordered_queue_set(int index, int offset)
+{
+    queue.items[index] = offset;
+    queue.heap_index[offset] = index;
+}
+
 static inline void ordered_queue_swap(int first, int second)
 {
     int temp = queue.items[first];
-    queue.items[first] = queue.items[second];
-    queue.items[second] = temp;
+    ordered_queue_set(first, queue.items[second]);
+    ordered_queue_set(second, temp);
 }
 
 void ordered_queue_reorder(int start_index)
@@ -128,15 +173,17 @@ void ordered_queue_reorder(int start_index)
 
 static inline int ordered_queue_pop(void)
 {
+    stats.heap_operations++;
     int min = queue.items[0];
-    queue.items[0] = queue.items[--queue.tail];
+    ordered_queue_set(0, queue.items[--queue.tail]);
     ordered_queue_reorder(0);
     return min;
 }
 
 static inline void ordered_queue_reduce_index(int index, int offset, int dist)
 {
-    queue.items[index] = offset;
+    stats.heap_operations++;
+    ordered_queue_set(index, offset);
     while (index && distance.possible.items[queue.items[ordered_queue_parent(index)]] > dist) {
         ordered_queue_swap(index, ordered_queue_parent(index));
         index = ordered_queue_parent(index);
@@ -147,17 +194,12 @@ static void ordered_enqueue(int next_offset, int current_dist, int remaining_dis
 {
     int possible_dist = remaining_dist + current_dist;
     int index = queue.tail;
+    touch_tile(next_offset);
     if (distance.possible.items[next_offset]) {
         if (distance.possible.items[next_offset] <= possible_dist) {
             return;
-        } else {
-            for (int i = 0; i < queue.tail; i++) {
-                if (queue.items[i] == next_offset) {
-                    index = i;
-                    break;
-                }
-            }
         }
+        index = queue.heap_index[next_offset];
     } else {
         queue.tail++;
     }
@@ -169,7 +211,7 @@ static void ordered_enqueue(int next_offset, int current_dist, int remaining_dis
 
 static inline int valid_offset(int grid_offset)
 {
-    return map_grid_is_valid_offset(grid_offset) && distance.determined.items[grid_offset] == 0;
+    return map_grid_is_valid_offset(grid_offset) && determined_distance(grid_offset) == 0;
 }
 
 static inline int distance_left(int x, int y)
@@ -181,6 +223,7 @@ static void route_queue_from_to(int src_x, int src_y, int dst_x, int dst_y, int
     void (*callback)(int next_offset, int dist, int remaining_dist))
 {
     clear_data();
+    stats.heap_operations = 0;
     distance.dst_x = dst_x;
     distance.dst_y = dst_y;
     int dest = map_grid_offset(dst_x, dst_y);
@@ -207,7 +250,6 @@ static void route_queue_from_to(int src_x, int src_y, int dst_x, int dst_y, int
 static void route_queue_all_from(int source, max_directions directions, int (*callback)(int next_offset, int dist), int is_boat)
 {
     clear_data();
-    map_grid_clear_u8(water_drag.items);
     enqueue(source, 1);
     int tiles = 0;
     while (queue.head != queue.tail) {
@@ -303,7 +345,7 @@ static int callback_calc_distance_build_road(int next_offset, int dist)
     switch (terrain_land_citizen.items[next_offset]) {
         case CITIZEN_N3_AQUEDUCT:
             if (!map_can_place_road_under_aqueduct(next_offset)) {
-                distance.determined.items[next_offset] = -1;
+                set_determined_distance(next_offset, -1);
                 blocked = 1;
             }
             break;
@@ -341,7 +383,7 @@ static int callback_calc_distance_build_aqueduct(int next_offset, int dist)
             break;
     }
     if (map_terrain_is(next_offset, TERRAIN_ROAD) && !map_can_place_aqueduct_on_road(next_offset)) {
-        distance.determined.items[next_offset] = -1;
+        set_determined_distance(next_offset, -1);
         blocked = 1;
     }
     if (!blocked) {
@@ -432,8 +474,17 @@ static int is_fighting_friendly(figure *f)
     return f->is_friendly && f->action_state == FIGURE_ACTION_150_ATTACK;
 }
 
+static inline void touch_fighting_status(int grid_offset)
+{
+    if (fighting_data.generation.items[grid_offset] != fighting_data.current_generation) {
+        fighting_data.generation.items[grid_offset] = fighting_data.current_generation;
+        fighting_data.status.items[grid_offset] = 0;
+    }
+}
+
 static inline int has_fighting_friendly(int grid_offset)
 {
+    touch_fighting_status(grid_offset);
     if (!(fighting_data.status.items[grid_offset] & 0x80)) {
         fighting_data.status.items[grid_offset] |= 0x80 | map_figure_foreach_until(grid_offset, is_fighting_friendly);
     }
@@ -447,6 +498,7 @@ static int is_fighting_enemy(figure *f)
 
 static inline int has_fighting_enemy(int grid_offset)
 {
+    touch_fighting_status(grid_offset);
     if (!(fighting_data.status.items[grid_offset] & 0x40)) {
         fighting_data.status.items[grid_offset] |= 0x40 | (map_figure_foreach_until(grid_offset, is_fighting_enemy) << 1);
     }
@@ -464,7 +516,7 @@ int map_routing_citizen_can_travel_over_land(int src_x, int src_y, int dst_x, in
 {
     ++stats.total_routes_calculated;
     route_queue_from_to(src_x, src_y, dst_x, dst_y, 0, callback_travel_citizen_land);
-    return distance.determined.items[map_grid_offset(dst_x, dst_y)] != 0;
+    return determined_distance(map_grid_offset(dst_x, dst_y)) != 0;
 }
 
 static void callback_travel_citizen_road_garden(int next_offset, int dist, int remaining_dist)
@@ -484,7 +536,7 @@ int map_routing_citizen_can_travel_over_road_garden(int src_x, int src_y, int ds
     }
     ++stats.total_routes_calculated;
     route_queue_from_to(src_x, src_y, dst_x, dst_y, 0, callback_travel_citizen_road_garden);
-    return distance.determined.items[dst_offset] != 0;
+    return determined_distance(dst_offset) != 0;
 }
 
 static void callback_travel_walls(int next_offset, int dist, int remaining_dist)
@@ -499,7 +551,7 @@ int map_routing_can_travel_over_walls(int src_x, int src_y, int dst_x, int dst_y
 {
     ++stats.total_routes_calculated;
     route_queue_from_to(src_x, src_y, dst_x, dst_y, 0, callback_travel_walls);
-    return distance.determined.items[map_grid_offset(dst_x, dst_y)] != 0;
+    return determined_distance(map_grid_offset(dst_x, dst_y)) != 0;
 }
 
 static void callback_travel_noncitizen_land_through_building(int next_offset, int dist, int remaining_dist)
@@ -535,7 +587,7 @@ int map_routing_noncitizen_can_travel_over_land(
     } else {
         route_queue_from_to(src_x, src_y, dst_x, dst_y, max_tiles, callback_travel_noncitizen_land);
     }
-    return distance.determined.items[map_grid_offset(dst_x, dst_y)] != 0;
+    return determined_distance(map_grid_offset(dst_x, dst_y)) != 0;
 }
 
 static void callback_travel_noncitizen_through_everything(int next_offset, int dist, int remaining_dist)
@@ -549,7 +601,63 @@ int map_routing_noncitizen_can_travel_through_everything(int src_x, int src_y, i
 {
     ++stats.total_routes_calculated;
     route_queue_from_to(src_x, src_y, dst_x, dst_y, 0, callback_travel_noncitizen_through_everything);
-    return distance.determined.items[map_grid_offset(dst_x, dst_y)] != 0;
+    return determined_distance(map_grid_offset(dst_x, dst_y)) != 0;
+}
+
+static void callback_travel_in_corridor(int next_offset, int dist, int remaining_dist)
+{
+    if (map_routing_hierarchy_in_corridor(next_offset)) {
+        state.corridor_callback(next_offset, dist, remaining_dist);
+    }
+}
+
+static corridor_result route_queue_in_corridor(routing_layer layer, int src_x, int src_y, int dst_x, int dst_y,
+    void (*callback)(int next_offset, int dist, int remaining_dist))
+{
+    int dst_offset = map_grid_offset(dst_x, dst_y);
+    corridor_result result = map_routing_hierarchy_find_corridor(layer, map_grid_offset(src_x, src_y), dst_offset);
+    if (result != CORRIDOR_FOUND) {
+        return result;
+    }
+    state.corridor_callback = callback;
+    route_queue_from_to(src_x, src_y, dst_x, dst_y, 0, callback_travel_in_corridor);
+    // units fighting inside the corridor can still block it
+    return determined_distance(dst_offset) != 0 ? CORRIDOR_FOUND : CORRIDOR_UNKNOWN;
+}
+
+int map_routing_citizen_can_travel_over_land_hierarchical(int src_x, int src_y, int dst_x, int dst_y)
+{
+    corridor_result result = route_queue_in_corridor(ROUTING_LAYER_CITIZEN_LAND,
+        src_x, src_y, dst_x, dst_y, callback_travel_citizen_land);
+    if (result == CORRIDOR_UNKNOWN) {
+        return map_routing_citizen_can_travel_over_land(src_x, src_y, dst_x, dst_y);
+    }
+    ++stats.total_routes_calculated;
+    return result == CORRIDOR_FOUND;
+}
+
+int map_routing_noncitizen_can_travel_over_land_hierarchical(int src_x, int src_y, int dst_x, int dst_y,
+    int max_tiles)
+{
+    corridor_result result = route_queue_in_corridor(ROUTING_LAYER_NONCITIZEN_LAND,
+        src_x, src_y, dst_x, dst_y, callback_travel_noncitizen_land);
+    if (result == CORRIDOR_UNKNOWN) {
+        return map_routing_noncitizen_can_travel_over_land(src_x, src_y, dst_x, dst_y, 0, max_tiles);
+    }
+    ++stats.total_routes_calculated;
+    ++stats.enemy_routes_calculated;
+    return result == CORRIDOR_FOUND;
+}
+
+int map_routing_can_travel_over_walls_hierarchical(int src_x, int src_y, int dst_x, int dst_y)
+{
+    corridor_result result = route_queue_in_corridor(ROUTING_LAYER_WALLS,
+        src_x, src_y, dst_x, dst_y, callback_travel_walls);
+    if (result == CORRIDOR_UNKNOWN) {
+        return map_routing_can_travel_over_walls(src_x, src_y, dst_x, dst_y);
+    }
+    ++stats.total_routes_calculated;
+    return result == CORRIDOR_FOUND;
 }
 
 void map_routing_block(int x, int y, int size)
@@ -559,14 +667,19 @@ void map_routing_block(int x, int y, int size)
     }
     for (int dy = 0; dy < size; dy++) {
         for (int dx = 0; dx < size; dx++) {
-            distance.determined.items[map_grid_offset(x + dx, y + dy)] = 0;
+            set_determined_distance(map_grid_offset(x + dx, y + dy), 0);
         }
     }
 }
 
 int map_routing_distance(int grid_offset)
 {
-    return distance.determined.items[grid_offset];
+    return determined_distance(grid_offset);
+}
+
+int map_routing_last_route_heap_operations(void)
+{
+    return stats.heap_operations;
 }
 
 void map_routing_save_state(buffer *buf)
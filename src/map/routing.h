@@ -20,6 +20,11 @@ void map_routing_delete_first_wall_or_aqueduct(int x, int y);
 
 int map_routing_distance(int grid_offset);
 
+/**
+ * Number of priority queue pushes, pops and decrease-key operations done by the last point-to-point route
+ */
+int map_routing_last_route_heap_operations(void);
+
 int map_routing_citizen_can_travel_over_land(int src_x, int src_y, int dst_x, int dst_y);
 int map_routing_citizen_can_travel_over_road_garden(int src_x, int src_y, int dst_x, int dst_y);
 int map_routing_can_travel_over_walls(int src_x, int src_y, int dst_x, int dst_y);
@@ -28,6 +33,16 @@ int map_routing_noncitizen_can_travel_over_land(
     int src_x, int src_y, int dst_x, int dst_y, int only_through_building_id, int max_tiles);
 int map_routing_noncitizen_can_travel_through_everything(int src_x, int src_y, int dst_x, int dst_y);
 
+/**
+ * Variants of the travel checks above that first find a corridor through the region graph
+ * and then only search the tiles inside it. They fall back to the full search when the
+ * region graph cannot decide.
+ */
+int map_routing_citizen_can_travel_over_land_hierarchical(int src_x, int src_y, int dst_x, int dst_y);
+int map_routing_noncitizen_can_travel_over_land_hierarchical(int src_x, int src_y, int dst_x, int dst_y,
+    int max_tiles);
+int map_routing_can_travel_over_walls_hierarchical(int src_x, int src_y, int dst_x, int dst_y);
+
 void map_routing_block(int x, int y, int size);
 
 void map_routing_save_state(buffer *buf);
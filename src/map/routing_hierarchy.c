@@ -0,0 +1,343 @@
+#include "routing_hierarchy.h"
+
+#include "map/grid.h"
+#include "map/routing_data.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define CLUSTER_SIZE 16
+#define CLUSTERS_PER_ROW ((GRID_SIZE + CLUSTER_SIZE - 1) / CLUSTER_SIZE)
+#define NUM_CLUSTERS (CLUSTERS_PER_ROW * CLUSTERS_PER_ROW)
+#define MAX_REGIONS 32
+#define NUM_NODES (NUM_CLUSTERS * MAX_REGIONS)
+#define MAX_HEAP (NUM_NODES * 4)
+
+enum {
+    NODE_UNVISITED = 0,
+    NODE_OPEN = 1,
+    NODE_CLOSED = 2
+};
+
+static const int TILE_OFFSETS[] = { -GRID_SIZE, 1, GRID_SIZE, -1 };
+static const int CLUSTER_OFFSETS_X[] = { 0, 1, 0, -1 };
+static const int CLUSTER_OFFSETS_Y[] = { -1, 0, 1, 0 };
+
+typedef struct {
+    int num_regions;
+    int needs_update;
+    int center_x[MAX_REGIONS];
+    int center_y[MAX_REGIONS];
+    uint32_t links[MAX_REGIONS][4]; // per direction, bit set for each connected region in the neighbouring cluster
+} cluster;
+
+typedef struct {
+    grid_u8 passable;
+    grid_u8 region; // region within the tile's cluster, starting at 1; 0 when impassable
+    cluster clusters[NUM_CLUSTERS];
+} hierarchy_layer;
+
+static hierarchy_layer layers[ROUTING_LAYER_MAX];
+
+static struct {
+    uint8_t state[NUM_NODES];
+    int cost[NUM_NODES];
+    int parent[NUM_NODES];
+    struct {
+        int node;
+        int priority;
+    } heap[MAX_HEAP];
+    int heap_size;
+} search;
+
+static struct {
+    routing_layer layer;
+    uint8_t nodes[NUM_NODES];
+} corridor;
+
+static int is_passable(routing_layer layer, int grid_offset)
+{
+    switch (layer) {
+        case ROUTING_LAYER_CITIZEN_LAND:
+            return terrain_land_citizen.items[grid_offset] >= CITIZEN_0_ROAD;
+        case ROUTING_LAYER_NONCITIZEN_LAND:
+            return terrain_land_noncitizen.items[grid_offset] >= NONCITIZEN_0_PASSABLE &&
+                terrain_land_noncitizen.items[grid_offset] < NONCITIZEN_5_FORT;
+        case ROUTING_LAYER_WALLS:
+            return terrain_walls.items[grid_offset] >= WALL_0_PASSABLE &&
+                terrain_walls.items[grid_offset] <= 2;
+        default:
+            return 0;
+    }
+}
+
+static inline int cluster_of(int grid_offset)
+{
+    int x = grid_offset % GRID_SIZE;
+    int y = grid_offset / GRID_SIZE;
+    return (y / CLUSTER_SIZE) * CLUSTERS_PER_ROW + x / CLUSTER_SIZE;
+}
+
+static inline int node_of(const hierarchy_layer *l, int grid_offset)
+{
+    return cluster_of(grid_offset) * MAX_REGIONS + l->region.items[grid_offset] - 1;
+}
+
+static void get_cluster_bounds(int cluster_id, int *x_min, int *y_min, int *x_max, int *y_max)
+{
+    *x_min = (cluster_id % CLUSTERS_PER_ROW) * CLUSTER_SIZE;
+    *y_min = (cluster_id / CLUSTERS_PER_ROW) * CLUSTER_SIZE;
+    *x_max = *x_min + CLUSTER_SIZE < GRID_SIZE ? *x_min + CLUSTER_SIZE : GRID_SIZE;
+    *y_max = *y_min + CLUSTER_SIZE < GRID_SIZE ? *y_min + CLUSTER_SIZE : GRID_SIZE;
+}
+
+static int get_neighbour_cluster(int cluster_id, int direction)
+{
+    int x = cluster_id % CLUSTERS_PER_ROW + CLUSTER_OFFSETS_X[direction];
+    int y = cluster_id / CLUSTERS_PER_ROW + CLUSTER_OFFSETS_Y[direction];
+    if (x < 0 || y < 0 || x >= CLUSTERS_PER_ROW || y >= CLUSTERS_PER_ROW) {
+        return -1;
+    }
+    return y * CLUSTERS_PER_ROW + x;
+}
+
+static void build_regions(hierarchy_layer *l, int cluster_id)
+{
+    static int stack[CLUSTER_SIZE * CLUSTER_SIZE];
+    int sum_x[MAX_REGIONS] = { 0 };
+    int sum_y[MAX_REGIONS] = { 0 };
+    int count[MAX_REGIONS] = { 0 };
+    int x_min, y_min, x_max, y_max;
+    get_cluster_bounds(cluster_id, &x_min, &y_min, &x_max, &y_max);
+    for (int y = y_min; y < y_max; y++) {
+        for (int x = x_min; x < x_max; x++) {
+            l->region.items[y * GRID_SIZE + x] = 0;
+        }
+    }
+    int num_regions = 0;
+    for (int y = y_min; y < y_max; y++) {
+        for (int x = x_min; x < x_max; x++) {
+            int grid_offset = y * GRID_SIZE + x;
+            if (!l->passable.items[grid_offset] || l->region.items[grid_offset]) {
+                continue;
+            }
+            // very fragmented clusters share their last region: this can only add connections,
+            // so the region graph never reports a reachable destination as unreachable
+            int region = num_regions < MAX_REGIONS ? ++num_regions : MAX_REGIONS;
+            int stack_size = 0;
+            l->region.items[grid_offset] = region;
+            stack[stack_size++] = grid_offset;
+            while (stack_size) {
+                int offset = stack[--stack_size];
+                int tile_x = offset % GRID_SIZE;
+                int tile_y = offset / GRID_SIZE;
+                sum_x[region - 1] += tile_x;
+                sum_y[region - 1] += tile_y;
+                count[region - 1]++;
+                for (int d = 0; d < 4; d++) {
+                    int next_x = tile_x + CLUSTER_OFFSETS_X[d];
+                    int next_y = tile_y + CLUSTER_OFFSETS_Y[d];
+                    if (next_x < x_min || next_x >= x_max || next_y < y_min || next_y >= y_max) {
+                        continue;
+                    }
+                    int next_offset = offset + TILE_OFFSETS[d];
+                    if (l->passable.items[next_offset] && !l->region.items[next_offset]) {
+                        l->region.items[next_offset] = region;
+                        stack[stack_size++] = next_offset;
+                    }
+                }
+            }
+        }
+    }
+    cluster *c = &l->clusters[cluster_id];
+    c->num_regions = num_regions;
+    for (int r = 0; r < num_regions; r++) {
+        c->center_x[r] = sum_x[r] / count[r];
+        c->center_y[r] = sum_y[r] / count[r];
+    }
+}
+
+static void update_links(hierarchy_layer *l, int cluster_id)
+{
+    int x_min, y_min, x_max, y_max;
+    get_cluster_bounds(cluster_id, &x_min, &y_min, &x_max, &y_max);
+    cluster *c = &l->clusters[cluster_id];
+    for (int d = 0; d < 4; d++) {
+        int opposite = (d + 2) % 4;
+        int neighbour_id = get_neighbour_cluster(cluster_id, d);
+        for (int r = 0; r < MAX_REGIONS; r++) {
+            c->links[r][d] = 0;
+        }
+        if (neighbour_id < 0) {
+            continue;
+        }
+        cluster *neighbour = &l->clusters[neighbour_id];
+        for (int r = 0; r < MAX_REGIONS; r++) {
+            neighbour->links[r][opposite] = 0;
+        }
+        int start, end, step;
+        switch (d) {
+            case 0: start = y_min * GRID_SIZE + x_min; end = start + (x_max - x_min); step = 1; break;
+            case 1: start = y_min * GRID_SIZE + x_max - 1; end = y_max * GRID_SIZE + x_max - 1; step = GRID_SIZE; break;
+            case 2: start = (y_max - 1) * GRID_SIZE + x_min; end = start + (x_max - x_min); step = 1; break;
+            default: start = y_min * GRID_SIZE + x_min; end = y_max * GRID_SIZE + x_min; step = GRID_SIZE; break;
+        }
+        for (int offset = start; offset < end; offset += step) {
+            int region = l->region.items[offset];
+            int neighbour_region = l->region.items[offset + TILE_OFFSETS[d]];
+            if (region && neighbour_region) {
+                c->links[region - 1][d] |= 1u << (neighbour_region - 1);
+                neighbour->links[neighbour_region - 1][opposite] |= 1u << (region - 1);
+            }
+        }
+    }
+}
+
+void map_routing_hierarchy_update(routing_layer layer)
+{
+    hierarchy_layer *l = &layers[layer];
+    for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        uint8_t passable = is_passable(layer, i);
+        if (l->passable.items[i] != passable) {
+            l->passable.items[i] = passable;
+            l->clusters[cluster_of(i)].needs_update = 1;
+        }
+    }
+    for (int i = 0; i < NUM_CLUSTERS; i++) {
+        if (l->clusters[i].needs_update) {
+            build_regions(l, i);
+        }
+    }
+    for (int i = 0; i < NUM_CLUSTERS; i++) {
+        if (l->clusters[i].needs_update) {
+            update_links(l, i);
+            l->clusters[i].needs_update = 0;
+        }
+    }
+}
+
+static int node_distance(const hierarchy_layer *l, int node, int x, int y)
+{
+    const cluster *c = &l->clusters[node / MAX_REGIONS];
+    int region = node % MAX_REGIONS;
+    return abs(c->center_x[region] - x) + abs(c->center_y[region] - y);
+}
+
+static int heap_push(int node, int priority)
+{
+    if (search.heap_size >= MAX_HEAP) {
+        return 0;
+    }
+    int index = search.heap_size++;
+    while (index && search.heap[(index - 1) / 2].priority > priority) {
+        search.heap[index] = search.heap[(index - 1) / 2];
+        index = (index - 1) / 2;
+    }
+    search.heap[index].node = node;
+    search.heap[index].priority = priority;
+    return 1;
+}
+
+static int heap_pop(void)
+{
+    int result = search.heap[0].node;
+    int last_node = search.heap[--search.heap_size].node;
+    int last_priority = search.heap[search.heap_size].priority;
+    int index = 0;
+    while (1) {
+        int child = 2 * index + 1;
+        if (child >= search.heap_size) {
+            break;
+        }
+        if (child + 1 < search.heap_size && search.heap[child + 1].priority < search.heap[child].priority) {
+            child++;
+        }
+        if (search.heap[child].priority >= last_priority) {
+            break;
+        }
+        search.heap[index] = search.heap[child];
+        index = child;
+    }
+    search.heap[index].node = last_node;
+    search.heap[index].priority = last_priority;
+    return result;
+}
+
+corridor_result map_routing_hierarchy_find_corridor(routing_layer layer, int src_offset, int dst_offset)
+{
+    const hierarchy_layer *l = &layers[layer];
+    if (!l->region.items[src_offset] || !l->region.items[dst_offset]) {
+        return CORRIDOR_UNKNOWN;
+    }
+    int src_node = node_of(l, src_offset);
+    int dst_node = node_of(l, dst_offset);
+    int dst_x = dst_offset % GRID_SIZE;
+    int dst_y = dst_offset / GRID_SIZE;
+
+    memset(search.state, NODE_UNVISITED, sizeof(search.state));
+    search.heap_size = 0;
+    search.cost[src_node] = 0;
+    search.parent[src_node] = -1;
+    search.state[src_node] = NODE_OPEN;
+    heap_push(src_node, node_distance(l, src_node, dst_x, dst_y));
+
+    int found = 0;
+    while (search.heap_size) {
+        int node = heap_pop();
+        if (search.state[node] == NODE_CLOSED) {
+            continue;
+        }
+        search.state[node] = NODE_CLOSED;
+        if (node == dst_node) {
+            found = 1;
+            break;
+        }
+        int cluster_id = node / MAX_REGIONS;
+        const cluster *c = &l->clusters[cluster_id];
+        int region = node % MAX_REGIONS;
+        for (int d = 0; d < 4; d++) {
+            uint32_t links = c->links[region][d];
+            if (!links) {
+                continue;
+            }
+            int neighbour_id = get_neighbour_cluster(cluster_id, d);
+            for (int r = 0; links; r++, links >>= 1) {
+                if (!(links & 1)) {
+                    continue;
+                }
+                int next = neighbour_id * MAX_REGIONS + r;
+                if (search.state[next] == NODE_CLOSED) {
+                    continue;
+                }
+                int cost = search.cost[node] + 1 +
+                    node_distance(l, next, c->center_x[region], c->center_y[region]);
+                if (search.state[next] == NODE_UNVISITED || cost < search.cost[next]) {
+                    search.cost[next] = cost;
+                    search.parent[next] = node;
+                    search.state[next] = NODE_OPEN;
+                    if (!heap_push(next, cost + node_distance(l, next, dst_x, dst_y))) {
+                        return CORRIDOR_UNKNOWN;
+                    }
+                }
+            }
+        }
+    }
+    if (!found) {
+        return CORRIDOR_NONE;
+    }
+    memset(corridor.nodes, 0, sizeof(corridor.nodes));
+    corridor.layer = layer;
+    for (int node = dst_node; node >= 0; node = search.parent[node]) {
+        corridor.nodes[node] = 1;
+    }
+    return CORRIDOR_FOUND;
+}
+
+int map_routing_hierarchy_in_corridor(int grid_offset)
+{
+    const hierarchy_layer *l = &layers[corridor.layer];
+    if (!l->region.items[grid_offset]) {
+        return 0;
+    }
+    return corridor.nodes[node_of(l, grid_offset)];
+}
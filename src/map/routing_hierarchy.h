@@ -0,0 +1,41 @@
+#ifndef MAP_ROUTING_HIERARCHY_H
+#define MAP_ROUTING_HIERARCHY_H
+
+typedef enum {
+    ROUTING_LAYER_CITIZEN_LAND = 0,
+    ROUTING_LAYER_NONCITIZEN_LAND = 1,
+    ROUTING_LAYER_WALLS = 2,
+    ROUTING_LAYER_MAX = 3
+} routing_layer;
+
+typedef enum {
+    CORRIDOR_UNKNOWN = -1,
+    CORRIDOR_NONE = 0,
+    CORRIDOR_FOUND = 1
+} corridor_result;
+
+/**
+ * Rebuilds the regions of all clusters whose passability changed since the last update.
+ * Must be called whenever the routing terrain of the layer is recalculated.
+ * @param layer Layer to update
+ */
+void map_routing_hierarchy_update(routing_layer layer);
+
+/**
+ * Searches the region graph for a corridor between two tiles
+ * @param layer Layer to search
+ * @param src_offset Source grid offset
+ * @param dst_offset Destination grid offset
+ * @return CORRIDOR_FOUND if a corridor was marked, CORRIDOR_NONE if the destination is unreachable
+ *         or CORRIDOR_UNKNOWN if the region graph cannot answer and a full search is needed
+ */
+corridor_result map_routing_hierarchy_find_corridor(routing_layer layer, int src_offset, int dst_offset);
+
+/**
+ * Checks whether a tile belongs to the corridor found by the last call to map_routing_hierarchy_find_corridor
+ * @param grid_offset Tile to check
+ * @return 1 if the tile is in the corridor, 0 otherwise
+ */
+int map_routing_hierarchy_in_corridor(int grid_offset);
+
+#endif // MAP_ROUTING_HIERARCHY_H
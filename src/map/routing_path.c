@@ -6,9 +6,7 @@
 #include "map/random.h"
 #include "map/routing.h"
 
-#define MAX_PATH 500
-
-static int direction_path[MAX_PATH];
+static int direction_path[MAX_ROUTING_PATH_LENGTH];
 
 static void adjust_tile_in_direction(int direction, int *x, int *y, int *grid_offset)
 {
@@ -86,7 +84,7 @@ int map_routing_get_path(uint8_t *path, int src_x, int src_y, int dst_x, int dst
         int forward_direction = (direction + 4) % 8;
         direction_path[num_tiles++] = forward_direction;
         last_direction = forward_direction;
-        if (num_tiles >= MAX_PATH) {
+        if (num_tiles >= MAX_ROUTING_PATH_LENGTH) {
             return 0;
         }
     }
@@ -140,7 +138,7 @@ int map_routing_get_path_on_water(uint8_t *path, int dst_x, int dst_y, int is_fl
         int forward_direction = (direction + 4) % 8;
         direction_path[num_tiles++] = forward_direction;
         last_direction = forward_direction;
-        if (num_tiles >= MAX_PATH) {
+        if (num_tiles >= MAX_ROUTING_PATH_LENGTH) {
             return 0;
         }
     }
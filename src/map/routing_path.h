@@ -3,6 +3,9 @@
 
 #include <stdint.h>
 
+// Routing distances below 998 are the only limit, so no valid path is longer than this
+#define MAX_ROUTING_PATH_LENGTH 1000
+
 int map_routing_get_path(uint8_t *path, int src_x, int src_y, int dst_x, int dst_y, int num_directions);
 
 int map_routing_get_path_on_water(uint8_t *path, int dst_x, int dst_y, int is_flotsam);
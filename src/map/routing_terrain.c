@@ -10,6 +10,7 @@
 #include "map/property.h"
 #include "map/random.h"
 #include "map/routing_data.h"
+#include "map/routing_hierarchy.h"
 #include "map/sprite.h"
 #include "map/terrain.h"
 
@@ -142,6 +143,7 @@ void map_routing_update_land_citizen(void)
             }
         }
     }
+    map_routing_hierarchy_update(ROUTING_LAYER_CITIZEN_LAND);
 }
 
 static int get_land_type_noncitizen(int grid_offset)
@@ -204,6 +206,7 @@ static void map_routing_update_land_noncitizen(void)
             }
         }
     }
+    map_routing_hierarchy_update(ROUTING_LAYER_NONCITIZEN_LAND);
 }
 
 static int is_surrounded_by_water(int grid_offset)
@@ -297,6 +300,7 @@ void map_routing_update_walls(void)
             }
         }
     }
+    map_routing_hierarchy_update(ROUTING_LAYER_WALLS);
 }
 
 int map_routing_is_wall_passable(int grid_offset)
@@ -1,6 +1,7 @@
 #include "terrain.h"
 
 #include "core/image.h"
+#include "map/dirty.h"
 #include "map/grid.h"
 #include "map/ring.h"
 #include "map/routing.h"
@@ -23,19 +24,27 @@ int map_terrain_get(int grid_offset)
     return terrain_grid.items[grid_offset];
 }
 
+static void set_terrain(int grid_offset, unsigned int terrain)
+{
+    if (terrain_grid.items[grid_offset] != terrain) {
+        terrain_grid.items[grid_offset] = terrain;
+        map_dirty_mark_tile(grid_offset);
+    }
+}
+
 void map_terrain_set(int grid_offset, int terrain)
 {
-    terrain_grid.items[grid_offset] = terrain;
+    set_terrain(grid_offset, terrain);
 }
 
 void map_terrain_add(int grid_offset, int terrain)
 {
-    terrain_grid.items[grid_offset] |= terrain;
+    set_terrain(grid_offset, terrain_grid.items[grid_offset] | terrain);
 }
 
 void map_terrain_remove(int grid_offset, int terrain)
 {
-    terrain_grid.items[grid_offset] &= ~terrain;
+    set_terrain(grid_offset, terrain_grid.items[grid_offset] & ~terrain);
 }
 
 void map_terrain_add_with_radius(int x, int y, int size, int radius, int terrain)
@@ -65,6 +74,7 @@ void map_terrain_remove_with_radius(int x, int y, int size, int radius, int terr
 void map_terrain_remove_all(int terrain)
 {
     map_grid_and_u32(terrain_grid.items, ~terrain);
+    map_dirty_mark_all();
 }
 
 int map_terrain_count_directly_adjacent_with_type(int grid_offset, int terrain)
@@ -356,12 +366,18 @@ void map_terrain_backup(void)
 
 void map_terrain_restore(void)
 {
+    for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        if (terrain_grid.items[i] != terrain_grid_backup.items[i]) {
+            map_dirty_mark_tile(i);
+        }
+    }
     map_grid_copy_u32(terrain_grid_backup.items, terrain_grid.items);
 }
 
 void map_terrain_clear(void)
 {
     map_grid_clear_u32(terrain_grid.items);
+    map_dirty_mark_all();
 }
 
 void map_terrain_init_outside_map(void)
@@ -378,6 +394,7 @@ void map_terrain_init_outside_map(void)
             }
         }
     }
+    map_dirty_mark_all();
 }
 
 void map_terrain_save_state(buffer *buf)
@@ -434,4 +451,5 @@ void map_terrain_load_state(buffer *buf, int expanded_terrain_data, buffer *imag
         map_grid_load_state_u16_to_u32(terrain_grid.items, buf);
     }
     determine_original_trees(images, legacy_image_buffer);
+    map_dirty_mark_all();
 }
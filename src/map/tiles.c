@@ -29,6 +29,15 @@
 
 static int aqueduct_include_construction = 0;
 
+static struct {
+    int shore_context[GRID_SIZE * GRID_SIZE];
+    uint8_t is_fortified[GRID_SIZE * GRID_SIZE];
+    grid_u8 terrain;
+    int is_prepared[GRID_SIZE];
+    int map_width;
+    int map_height;
+} water_rows;
+
 
 static int is_clear(int x, int y, int size, int disallowed_terrain, int check_image)
 {
@@ -872,32 +881,51 @@ void map_tiles_update_region_meadow(int x_min, int y_min, int x_max, int y_max)
     foreach_region_tile(x_min, y_min, x_max, y_max, update_meadow_tile);
 }
 
+static int get_shore_image(const terrain_image *img, int is_fortified)
+{
+    int image_id = image_group(GROUP_TERRAIN_WATER) + img->group_offset + img->item_offset;
+    if (is_fortified) {
+        int base = image_group(GROUP_TERRAIN_WATER_SHORE);
+        switch (img->group_offset) {
+            case 8: image_id = base + 10; break;
+            case 12: image_id = base + 11; break;
+            case 16: image_id = base + 9; break;
+            case 20: image_id = base + 8; break;
+            case 24: image_id = base + 18; break;
+            case 28: image_id = base + 16; break;
+            case 32: image_id = base + 19; break;
+            case 36: image_id = base + 17; break;
+            case 50: image_id = base + 12; break;
+            case 51: image_id = base + 14; break;
+            case 52: image_id = base + 13; break;
+            case 53: image_id = base + 15; break;
+        }
+    }
+    return image_id;
+}
+
+static int is_fortified_shore(int x, int y)
+{
+    return map_terrain_exists_tile_in_radius_with_type(x, y, 1, 2, TERRAIN_BUILDING);
+}
+
+static int is_shore_tile(int grid_offset)
+{
+    return (map_terrain_get(grid_offset) & (TERRAIN_WATER | TERRAIN_BUILDING)) == TERRAIN_WATER;
+}
+
+static void set_water_tile_image(int grid_offset, int image_id)
+{
+    map_image_set(grid_offset, image_id);
+    map_property_set_multi_tile_size(grid_offset, 1);
+    map_property_mark_draw_tile(grid_offset);
+}
+
 static void set_water_image(int x, int y, int grid_offset)
 {
-    if ((map_terrain_get(grid_offset) & (TERRAIN_WATER | TERRAIN_BUILDING)) == TERRAIN_WATER) {
+    if (is_shore_tile(grid_offset)) {
         const terrain_image *img = map_image_context_get_shore(grid_offset);
-        int image_id = image_group(GROUP_TERRAIN_WATER) + img->group_offset + img->item_offset;
-        if (map_terrain_exists_tile_in_radius_with_type(x, y, 1, 2, TERRAIN_BUILDING)) {
-            // fortified shore
-            int base = image_group(GROUP_TERRAIN_WATER_SHORE);
-            switch (img->group_offset) {
-                case 8: image_id = base + 10; break;
-                case 12: image_id = base + 11; break;
-                case 16: image_id = base + 9; break;
-                case 20: image_id = base + 8; break;
-                case 24: image_id = base + 18; break;
-                case 28: image_id = base + 16; break;
-                case 32: image_id = base + 19; break;
-                case 36: image_id = base + 17; break;
-                case 50: image_id = base + 12; break;
-                case 51: image_id = base + 14; break;
-                case 52: image_id = base + 13; break;
-                case 53: image_id = base + 15; break;
-            }
-        }
-        map_image_set(grid_offset, image_id);
-        map_property_set_multi_tile_size(grid_offset, 1);
-        map_property_mark_draw_tile(grid_offset);
+        set_water_tile_image(grid_offset, get_shore_image(img, is_fortified_shore(x, y)));
     }
 }
 
@@ -908,9 +936,95 @@ static void update_water_tile(int x, int y, int grid_offset)
     }
 }
 
+static void set_prepared_water_image(int x, int y, int grid_offset)
+{
+    if (is_shore_tile(grid_offset)) {
+        const terrain_image *img = map_image_context_get_shore_for_context(water_rows.shore_context[grid_offset]);
+        set_water_tile_image(grid_offset, get_shore_image(img, water_rows.is_fortified[grid_offset]));
+    }
+}
+
+static void update_prepared_water_tile(int x, int y, int grid_offset)
+{
+    if (map_terrain_is(grid_offset, TERRAIN_WATER) && !map_terrain_is(grid_offset, TERRAIN_BUILDING)) {
+        foreach_region_tile(x - 1, y - 1, x + 1, y + 1, set_prepared_water_image);
+    }
+}
+
+static int get_water_terrain(int grid_offset)
+{
+    return map_terrain_get(grid_offset) & (TERRAIN_WATER | TERRAIN_BUILDING);
+}
+
+static void unprepare_water_rows(int y_min, int y_max)
+{
+    for (int y = y_min < 0 ? 0 : y_min; y <= y_max && y < GRID_SIZE; y++) {
+        water_rows.is_prepared[y] = 0;
+    }
+}
+
+static void update_water_terrain(void)
+{
+    if (water_rows.map_width != map_data.width || water_rows.map_height != map_data.height) {
+        water_rows.map_width = map_data.width;
+        water_rows.map_height = map_data.height;
+        unprepare_water_rows(0, GRID_SIZE - 1);
+    }
+    for (int y = 0; y < map_data.height; y++) {
+        int grid_offset = map_grid_offset(0, y);
+        int changed = 0;
+        for (int x = 0; x < map_data.width; x++, grid_offset++) {
+            int terrain = get_water_terrain(grid_offset);
+            if (water_rows.terrain.items[grid_offset] != terrain) {
+                water_rows.terrain.items[grid_offset] = terrain;
+                changed = 1;
+            }
+        }
+        if (changed) {
+            // shore contexts and fortified shores look up to two tiles away
+            unprepare_water_rows(y - 2, y + 2);
+        }
+    }
+}
+
+static void prepare_water_row(int y)
+{
+    int grid_offset = map_grid_offset(0, y);
+    for (int x = 0; x < map_data.width; x++, grid_offset++) {
+        // only the matching context is stored: the image variant is picked when the images are set
+        if (is_shore_tile(grid_offset)) {
+            water_rows.shore_context[grid_offset] = map_image_context_find_shore(grid_offset);
+            water_rows.is_fortified[grid_offset] = is_fortified_shore(x, y);
+        }
+    }
+    water_rows.is_prepared[y] = 1;
+}
+
+void map_tiles_prepare_water(int part, int num_parts)
+{
+    update_water_terrain();
+    int y_min = map_data.height * part / num_parts;
+    int y_max = map_data.height * (part + 1) / num_parts;
+    for (int y = y_min; y < y_max; y++) {
+        if (!water_rows.is_prepared[y]) {
+            prepare_water_row(y);
+        }
+    }
+}
+
 void map_tiles_update_all_water(void)
 {
-    foreach_map_tile(update_water_tile);
+    // prepared rows stay valid as long as the water and building terrain around them is unchanged
+    update_water_terrain();
+    for (int y = 0; y < map_data.height; y++) {
+        if (!water_rows.is_prepared[y]) {
+            prepare_water_row(y);
+        }
+    }
+    // the shore image variants rotate on every lookup, so the lookups are repeated in the order of
+    // update_water_tile(): only the context matching is taken from the prepared rows
+    foreach_map_tile(update_prepared_water_tile);
+    unprepare_water_rows(0, GRID_SIZE - 1);
 }
 
 void map_tiles_update_region_water(int x_min, int y_min, int x_max, int y_max)
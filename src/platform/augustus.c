@@ -43,6 +43,8 @@
 #endif
 
 #ifdef DRAW_FPS
+#include "core/string.h"
+#include "game/profiler.h"
 #include "graphics/window.h"
 #include "graphics/graphics.h"
 #include "graphics/text.h"
@@ -114,6 +116,14 @@ void system_exit(void)
     post_event(USER_EVENT_QUIT);
 }
 
+uint64_t system_get_microseconds(void)
+{
+    Uint64 counter = SDL_GetPerformanceCounter();
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    // split the multiplication to avoid overflowing on high frequency counters
+    return counter / frequency * 1000000 + counter % frequency * 1000000 / frequency;
+}
+
 void system_resize(int width, int height)
 {
     static int s_width;
@@ -148,12 +158,79 @@ static void platform_per_frame_callback(void)
 #endif
 
 #ifdef DRAW_FPS
+#define PROFILER_OVERLAY_LINES 8
+#define PROFILER_CSV_FILE "augustus-profile.csv"
+
 static struct {
     int frame_count;
     int last_fps;
     Uint32 last_update_time;
 } fps = { 0, 0, 0 };
 
+static struct {
+    profiler_section sections[PROFILER_OVERLAY_LINES];
+    profiler_stats stats[PROFILER_OVERLAY_LINES];
+    int num_lines;
+} profile;
+
+static void update_profiler_overlay(void)
+{
+    // keep the sections with the highest 99th percentile
+    profile.num_lines = 0;
+    for (int i = 0; i < PROFILER_SECTION_MAX; i++) {
+        profiler_stats stats;
+        profiler_get_stats(i, &stats);
+        if (!stats.samples || i == PROFILER_SECTION_FIGURES || i == PROFILER_SECTION_DRAW) {
+            continue;
+        }
+        int pos = profile.num_lines;
+        while (pos > 0 && profile.stats[pos - 1].p99 < stats.p99) {
+            if (pos < PROFILER_OVERLAY_LINES) {
+                profile.sections[pos] = profile.sections[pos - 1];
+                profile.stats[pos] = profile.stats[pos - 1];
+            }
+            pos--;
+        }
+        if (pos < PROFILER_OVERLAY_LINES) {
+            profile.sections[pos] = i;
+            profile.stats[pos] = stats;
+            if (profile.num_lines < PROFILER_OVERLAY_LINES) {
+                profile.num_lines++;
+            }
+        }
+    }
+}
+
+static void draw_profiler_line(int line, profiler_section section, const profiler_stats *stats)
+{
+    char name[32];
+    char text[80];
+    profiler_get_section_name(section, name, sizeof(name));
+    snprintf(text, sizeof(text), "%s: %d / %d / %d us", name, stats->mean, stats->p99, stats->max);
+    text_draw(string_from_ascii(text), 5, 50 + 14 * line, FONT_SMALL_PLAIN, COLOR_BLACK);
+}
+
+static void draw_profiler_overlay(void)
+{
+    // mean / p99 / max of the figures, draw and the slowest sections
+    graphics_fill_rect(0, 44, 200, 14 * (profile.num_lines + 2) + 8, COLOR_WHITE);
+    profiler_stats stats;
+    profiler_get_stats(PROFILER_SECTION_FIGURES, &stats);
+    draw_profiler_line(0, PROFILER_SECTION_FIGURES, &stats);
+    profiler_get_stats(PROFILER_SECTION_DRAW, &stats);
+    draw_profiler_line(1, PROFILER_SECTION_DRAW, &stats);
+    for (int i = 0; i < profile.num_lines; i++) {
+        draw_profiler_line(i + 2, profile.sections[i], &profile.stats[i]);
+    }
+}
+
+static void write_profiler_csv(void)
+{
+    if (profiler_write_csv(PROFILER_CSV_FILE)) {
+        SDL_Log("Profiler data written to %s", PROFILER_CSV_FILE);
+    }
+}
+
 static void run_and_draw(void)
 {
     time_millis time_before_run = SDL_GetTicks();
@@ -169,6 +246,7 @@ static void run_and_draw(void)
         fps.last_fps = fps.frame_count;
         fps.last_update_time = time_after_draw;
         fps.frame_count = 0;
+        update_profiler_overlay();
     }
     if (window_is(WINDOW_CITY) || window_is(WINDOW_CITY_MILITARY) || window_is(WINDOW_SLIDING_SIDEBAR)) {
         int y_offset = 24;
@@ -180,6 +258,7 @@ static void run_and_draw(void)
             'g', "", 40, y_offset_text, FONT_NORMAL_PLAIN, COLOR_FONT_RED);
         text_draw_number(time_after_draw - time_between_run_and_draw,
             'd', "", 70, y_offset_text, FONT_NORMAL_PLAIN, COLOR_FONT_RED);
+        draw_profiler_overlay();
     }
     platform_renderer_render();
 }
@@ -366,6 +445,9 @@ static void teardown(void)
 {
     log_repeated_messages();
     SDL_Log("Exiting game");
+#ifdef DRAW_FPS
+    write_profiler_csv();
+#endif
     game_exit();
     platform_screen_destroy();
     SDL_Quit();
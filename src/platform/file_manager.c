@@ -369,6 +369,25 @@ int platform_file_manager_remove_file(const char *filename)
     return remove(vita_prepend_path(filename)) == 0;
 }
 
+int platform_file_manager_rename_file(const char *filename, const char *new_filename)
+{
+    char full_filename[2 * FILE_NAME_MAX];
+    strncpy(full_filename, vita_prepend_path(filename), 2 * FILE_NAME_MAX - 1);
+    full_filename[2 * FILE_NAME_MAX - 1] = 0;
+    char temp_filename[FILE_NAME_MAX];
+    strncpy(temp_filename, new_filename, FILE_NAME_MAX - 1);
+    temp_filename[FILE_NAME_MAX - 1] = 0;
+    int new_file_exists = file_exists(temp_filename, NOT_LOCALIZED);
+    if (rename(full_filename, vita_prepend_path(new_filename)) != 0) {
+        return 0;
+    }
+    platform_file_manager_cache_delete_file_info(filename);
+    if (!new_file_exists) {
+        platform_file_manager_cache_add_file_info(new_filename);
+    }
+    return 1;
+}
+
 #elif defined(_WIN32)
 
 FILE *platform_file_manager_open_file(const char *filename, const char *mode)
@@ -408,6 +427,16 @@ int platform_file_manager_remove_file(const char *filename)
     return result == 0;
 }
 
+int platform_file_manager_rename_file(const char *filename, const char *new_filename)
+{
+    wchar_t *wfile = utf8_to_wchar(filename);
+    wchar_t *wnew_file = utf8_to_wchar(new_filename);
+    int result = MoveFileExW(wfile, wnew_file, MOVEFILE_REPLACE_EXISTING);
+    free(wfile);
+    free(wnew_file);
+    return result != 0;
+}
+
 #elif defined(__ANDROID__)
 
 FILE *platform_file_manager_open_file(const char *filename, const char *mode)
@@ -429,6 +458,12 @@ int platform_file_manager_remove_file(const char *filename)
     return android_remove_file(filename);
 }
 
+int platform_file_manager_rename_file(const char *filename, const char *new_filename)
+{
+    // not supported by the storage access framework
+    return 0;
+}
+
 #elif defined(__EMSCRIPTEN__)
 
 FILE *platform_file_manager_open_file(const char *filename, const char *mode)
@@ -448,6 +483,17 @@ int platform_file_manager_remove_file(const char *filename)
     return 0;
 }
 
+int platform_file_manager_rename_file(const char *filename, const char *new_filename)
+{
+    if (rename(filename, new_filename) == 0) {
+        EM_ASM(
+            Module.syncFS();
+        );
+        return 1;
+    }
+    return 0;
+}
+
 FILE *platform_file_manager_open_asset(const char *asset, const char *mode)
 {
     get_assets_directory();
@@ -479,6 +525,26 @@ int platform_file_manager_remove_file(const char *filename)
     return remove(filename) == 0;
 }
 
+int platform_file_manager_rename_file(const char *filename, const char *new_filename)
+{
+#ifdef USE_FILE_CACHE
+    char temp_filename[FILE_NAME_MAX];
+    strncpy(temp_filename, new_filename, FILE_NAME_MAX - 1);
+    temp_filename[FILE_NAME_MAX - 1] = 0;
+    int new_file_exists = file_exists(temp_filename, NOT_LOCALIZED);
+#endif
+    if (rename(filename, new_filename) != 0) {
+        return 0;
+    }
+#ifdef USE_FILE_CACHE
+    platform_file_manager_cache_delete_file_info(filename);
+    if (!new_file_exists) {
+        platform_file_manager_cache_add_file_info(new_filename);
+    }
+#endif
+    return 1;
+}
+
 FILE *platform_file_manager_open_asset(const char *asset, const char *mode)
 {
     get_assets_directory();
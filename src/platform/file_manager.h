@@ -90,6 +90,14 @@ int platform_file_manager_close_file(FILE *stream);
  */
 int platform_file_manager_remove_file(const char *filename);
 
+/**
+ * Renames a file, replacing the destination if it exists
+ * @param filename The file to rename
+ * @param new_filename The new name of the file
+ * @return 1 if renaming was successful, 0 otherwise
+ */
+int platform_file_manager_rename_file(const char *filename, const char *new_filename);
+
 /**
  * Creates a directory
  * @param path The full path to the new directory
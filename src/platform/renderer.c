@@ -39,6 +39,9 @@
 
 #define MAX_UNPACKED_IMAGES 10
 
+#define MAX_BATCH_VERTICES 4096
+#define MAX_BATCH_INDICES (MAX_BATCH_VERTICES * 2)
+
 #define MAX_PACKED_IMAGE_SIZE 64000
 
 #ifdef __ANDROID__
@@ -102,13 +105,61 @@ static struct {
 #ifdef USE_TEXTURE_SCALE_MODE
     float city_scale;
 #endif
+#ifdef USE_RENDER_GEOMETRY
+    struct {
+        SDL_Texture *texture;
+        int texture_width;
+        int texture_height;
+        float xy[MAX_BATCH_VERTICES * 2];
+        float uv[MAX_BATCH_VERTICES * 2];
+        SDL_Color colors[MAX_BATCH_VERTICES];
+        int indices[MAX_BATCH_INDICES];
+        int num_vertices;
+        int num_indices;
+    } batch;
+#endif
 } data;
 
+static void flush_sprite_batch(void)
+{
+#ifdef USE_RENDER_GEOMETRY
+    if (!data.batch.num_indices) {
+        return;
+    }
+    SDL_RenderGeometryRaw(data.renderer, data.batch.texture,
+        data.batch.xy, 2 * sizeof(float), data.batch.colors, sizeof(SDL_Color),
+        data.batch.uv, 2 * sizeof(float), data.batch.num_vertices,
+        data.batch.indices, data.batch.num_indices, sizeof(int));
+    data.batch.num_vertices = 0;
+    data.batch.num_indices = 0;
+#endif
+}
+
+static void flush_sprite_batch_if_using(SDL_Texture *texture)
+{
+#ifdef USE_RENDER_GEOMETRY
+    if (data.batch.texture == texture) {
+        flush_sprite_batch();
+    }
+#endif
+}
+
+static void forget_batched_texture(SDL_Texture *texture)
+{
+#ifdef USE_RENDER_GEOMETRY
+    if (data.batch.texture == texture) {
+        flush_sprite_batch();
+        data.batch.texture = 0;
+    }
+#endif
+}
+
 static int save_screen_buffer(color_t *pixels, int x, int y, int width, int height, int row_width)
 {
     if (data.paused) {
         return 0;
     }
+    flush_sprite_batch();
     SDL_Rect rect = { x, y, width, height };
     return SDL_RenderReadPixels(data.renderer, &rect, SDL_PIXELFORMAT_ARGB8888, pixels, row_width * sizeof(color_t)) == 0;
 }
@@ -118,6 +169,7 @@ static void draw_line(int x_start, int x_end, int y_start, int y_end, color_t co
     if (data.paused) {
         return;
     }
+    flush_sprite_batch();
     SDL_SetRenderDrawColor(data.renderer,
         (color & COLOR_CHANNEL_RED) >> COLOR_BITSHIFT_RED,
         (color & COLOR_CHANNEL_GREEN) >> COLOR_BITSHIFT_GREEN,
@@ -131,6 +183,7 @@ static void draw_rect(int x_start, int x_end, int y_start, int y_end, color_t co
     if (data.paused) {
         return;
     }
+    flush_sprite_batch();
     SDL_SetRenderDrawColor(data.renderer,
         (color & COLOR_CHANNEL_RED) >> COLOR_BITSHIFT_RED,
         (color & COLOR_CHANNEL_GREEN) >> COLOR_BITSHIFT_GREEN,
@@ -145,6 +198,7 @@ static void fill_rect(int x_start, int x_end, int y_start, int y_end, color_t co
     if (data.paused) {
         return;
     }
+    flush_sprite_batch();
     SDL_SetRenderDrawColor(data.renderer,
         (color & COLOR_CHANNEL_RED) >> COLOR_BITSHIFT_RED,
         (color & COLOR_CHANNEL_GREEN) >> COLOR_BITSHIFT_GREEN,
@@ -159,6 +213,7 @@ static void set_clip_rectangle(int x, int y, int width, int height)
     if (data.paused) {
         return;
     }
+    flush_sprite_batch();
     SDL_Rect clip = { x, y, width, height };
     SDL_RenderSetClipRect(data.renderer, &clip);
 }
@@ -168,6 +223,7 @@ static void reset_clip_rectangle(void)
     if (data.paused) {
         return;
     }
+    flush_sprite_batch();
     SDL_RenderSetClipRect(data.renderer, NULL);
 }
 
@@ -176,6 +232,7 @@ static void set_viewport(int x, int y, int width, int height)
     if (data.paused) {
         return;
     }
+    flush_sprite_batch();
     SDL_Rect viewport = { x, y, width, height };
     SDL_RenderSetViewport(data.renderer, &viewport);
 }
@@ -185,6 +242,7 @@ static void reset_viewport(void)
     if (data.paused) {
         return;
     }
+    flush_sprite_batch();
     SDL_RenderSetViewport(data.renderer, NULL);
     SDL_RenderSetClipRect(data.renderer, NULL);
 }
@@ -194,6 +252,7 @@ static void clear_screen(void)
     if (data.paused) {
         return;
     }
+    flush_sprite_batch();
     SDL_SetRenderDrawColor(data.renderer, 0, 0, 0, 0xff);
     SDL_RenderClear(data.renderer);
 }
@@ -213,6 +272,7 @@ static void free_texture_atlas(atlas_type type)
     data.texture_lists[type] = 0;
     for (int i = 0; i < data.atlas_data[type].num_images; i++) {
         if (list[i]) {
+            forget_batched_texture(list[i]);
             SDL_DestroyTexture(list[i]);
         }
     }
@@ -365,6 +425,7 @@ static void free_all_textures(void)
     }
     for (int i = 0; i < CUSTOM_IMAGE_MAX; i++) {
         if (data.custom_textures[i].texture) {
+            forget_batched_texture(data.custom_textures[i].texture);
             SDL_DestroyTexture(data.custom_textures[i].texture);
             data.custom_textures[i].texture = 0;
 #ifndef __vita__
@@ -379,6 +440,7 @@ static void free_all_textures(void)
     while (texture_info) {
         buffer_texture *current = texture_info;
         texture_info = texture_info->next;
+        forget_batched_texture(current->texture);
         SDL_DestroyTexture(current->texture);
         free(current);
     }
@@ -388,6 +450,7 @@ static void free_all_textures(void)
 
     for (int i = 0; i < MAX_UNPACKED_IMAGES; i++) {
         if (data.unpacked_images[i].texture) {
+            forget_batched_texture(data.unpacked_images[i].texture);
             SDL_DestroyTexture(data.unpacked_images[i].texture);
         }
     }
@@ -417,21 +480,47 @@ static SDL_Texture *get_texture(int texture_id)
 }
 
 #ifdef USE_RENDER_GEOMETRY
-static const SDL_Color *convert_color(color_t color)
+static void set_sprite_batch_texture(SDL_Texture *texture)
+{
+    if (data.batch.texture == texture) {
+        return;
+    }
+    flush_sprite_batch();
+    data.batch.texture = texture;
+    SDL_QueryTexture(texture, 0, 0, &data.batch.texture_width, &data.batch.texture_height);
+}
+
+static void add_to_sprite_batch(const float *xy, const float *uv, int num_vertices,
+    const int *indices, int num_indices, color_t color)
 {
-    static SDL_Color new_color;
-    new_color.a = (color & COLOR_CHANNEL_ALPHA) >> COLOR_BITSHIFT_ALPHA;
-    new_color.r = (color & COLOR_CHANNEL_RED) >> COLOR_BITSHIFT_RED;
-    new_color.g = (color & COLOR_CHANNEL_GREEN) >> COLOR_BITSHIFT_GREEN;
-    new_color.b = (color & COLOR_CHANNEL_BLUE) >> COLOR_BITSHIFT_BLUE;
-    return &new_color;
+    if (data.batch.num_vertices + num_vertices > MAX_BATCH_VERTICES ||
+        data.batch.num_indices + num_indices > MAX_BATCH_INDICES) {
+        flush_sprite_batch();
+    }
+    SDL_Color vertex_color;
+    vertex_color.a = (color & COLOR_CHANNEL_ALPHA) >> COLOR_BITSHIFT_ALPHA;
+    vertex_color.r = (color & COLOR_CHANNEL_RED) >> COLOR_BITSHIFT_RED;
+    vertex_color.g = (color & COLOR_CHANNEL_GREEN) >> COLOR_BITSHIFT_GREEN;
+    vertex_color.b = (color & COLOR_CHANNEL_BLUE) >> COLOR_BITSHIFT_BLUE;
+    int first_vertex = data.batch.num_vertices;
+    memcpy(&data.batch.xy[first_vertex * 2], xy, 2 * sizeof(float) * num_vertices);
+    memcpy(&data.batch.uv[first_vertex * 2], uv, 2 * sizeof(float) * num_vertices);
+    for (int i = 0; i < num_vertices; i++) {
+        data.batch.colors[first_vertex + i] = vertex_color;
+    }
+    for (int i = 0; i < num_indices; i++) {
+        data.batch.indices[data.batch.num_indices + i] = first_vertex + indices[i];
+    }
+    data.batch.num_vertices += num_vertices;
+    data.batch.num_indices += num_indices;
 }
 
 static void draw_texture_raw(const image *img, SDL_Texture *texture,
     const SDL_Rect *src_coords, const SDL_FRect *dst_coords, color_t color, float scale)
 {
-    int texture_width, texture_height;
-    SDL_QueryTexture(texture, 0, 0, &texture_width, &texture_height);
+    set_sprite_batch_texture(texture);
+    int texture_width = data.batch.texture_width;
+    int texture_height = data.batch.texture_height;
 
     float texture_coord_correction = scale == 1.0f ? 0.0f : 0.5f;
 
@@ -449,8 +538,7 @@ static void draw_texture_raw(const image *img, SDL_Texture *texture,
     const float xy[8] = { maxx, miny, minx, miny, minx, maxy, maxx, maxy };
     const int indices[6] = { 0, 1, 2, 0, 2, 3 };
 
-    SDL_RenderGeometryRaw(data.renderer, texture, xy, 2 * sizeof(float), convert_color(color), 0,
-        uv, 2 * sizeof(float), 4, indices, sizeof(indices) / sizeof(int), sizeof(int));
+    add_to_sprite_batch(xy, uv, 4, indices, sizeof(indices) / sizeof(int), color);
 }
 
 static void draw_isometric_footprint_raw(const image *img, SDL_Texture *texture,
@@ -462,8 +550,9 @@ static void draw_isometric_footprint_raw(const image *img, SDL_Texture *texture,
     int height = tiles * 30;
     int half_height = tiles * 15;
 
-    int texture_width, texture_height;
-    SDL_QueryTexture(texture, 0, 0, &texture_width, &texture_height);
+    set_sprite_batch_texture(texture);
+    int texture_width = data.batch.texture_width;
+    int texture_height = data.batch.texture_height;
 
     float texture_coord_correction = scale == 1.0f ? 0.0f : 0.5f;
 
@@ -488,8 +577,7 @@ static void draw_isometric_footprint_raw(const image *img, SDL_Texture *texture,
     const float xy[8] = { medx, miny, minx, medy, medx, maxy, maxx, medy };
     const int indices[6] = { 0, 1, 2, 0, 2, 3 };
 
-    SDL_RenderGeometryRaw(data.renderer, texture, xy, 2 * sizeof(float), convert_color(color), 0,
-        uv, 2 * sizeof(float), 4, indices, sizeof(indices) / sizeof(int), sizeof(int));
+    add_to_sprite_batch(xy, uv, 4, indices, sizeof(indices) / sizeof(int), color);
 }
 
 static void draw_isometric_top_raw(const image *img, SDL_Texture *texture,
@@ -499,8 +587,9 @@ static void draw_isometric_top_raw(const image *img, SDL_Texture *texture,
     int half_width = tiles * 30 - 1;
     int half_height = tiles * 15;
 
-    int texture_width, texture_height;
-    SDL_QueryTexture(texture, 0, 0, &texture_width, &texture_height);
+    set_sprite_batch_texture(texture);
+    int texture_width = data.batch.texture_width;
+    int texture_height = data.batch.texture_height;
 
     float texture_coord_correction = scale == 1.0f ? 0.0f : 0.5f;
 
@@ -524,8 +613,7 @@ static void draw_isometric_top_raw(const image *img, SDL_Texture *texture,
     const float xy[10] = { minx, miny, maxx, miny, medx, medy, minx, maxy, maxx, maxy };
     const int indices[9] = { 0, 1, 2, 0, 2, 3, 1, 2, 4 };
 
-    SDL_RenderGeometryRaw(data.renderer, texture, xy, 2 * sizeof(float), convert_color(color), 0,
-        uv, 2 * sizeof(float), 5, indices, sizeof(indices) / sizeof(int), sizeof(int));
+    add_to_sprite_batch(xy, uv, 5, indices, sizeof(indices) / sizeof(int), color);
 }
 #endif
 
@@ -540,6 +628,7 @@ static void set_texture_scale_mode(SDL_Texture *texture, float scale)
         SDL_ScaleMode texture_scale_mode = scale != 1.0f ? SDL_ScaleModeLinear : SDL_ScaleModeNearest;
         SDL_ScaleMode desired_scale_mode = data.city_scale == scale ? city_scale_mode : texture_scale_mode;
         if (current_scale_mode != desired_scale_mode) {
+            flush_sprite_batch_if_using(texture);
             SDL_SetTextureScaleMode(texture, desired_scale_mode);
         }
     }
@@ -679,10 +768,12 @@ static void draw_isometric_top(const image *img, int x, int y, color_t color, fl
 
 static void create_custom_texture(custom_image_type type, int width, int height)
 {
+    flush_sprite_batch();
     if (data.paused) {
         return;
     }
     if (data.custom_textures[type].texture) {
+        forget_batched_texture(data.custom_textures[type].texture);
         SDL_DestroyTexture(data.custom_textures[type].texture);
         data.custom_textures[type].texture = 0;
     }
@@ -709,6 +800,7 @@ static color_t *get_custom_texture_buffer(custom_image_type type, int *actual_te
     }
 
 #ifdef __vita__
+    flush_sprite_batch_if_using(data.custom_textures[type].texture);
     int pitch;
     SDL_LockTexture(data.custom_textures[type].texture, NULL, (void **) &data.custom_textures[type].buffer, &pitch);
     if (actual_texture_width) {
@@ -741,6 +833,7 @@ static void update_custom_texture(custom_image_type type)
     if (data.paused || !data.custom_textures[type].texture || !data.custom_textures[type].buffer) {
         return;
     }
+    flush_sprite_batch_if_using(data.custom_textures[type].texture);
     int width, height;
     SDL_QueryTexture(data.custom_textures[type].texture, NULL, NULL, &width, &height);
     SDL_UpdateTexture(data.custom_textures[type].texture, NULL,
@@ -766,6 +859,7 @@ static int save_to_texture(int texture_id, int x, int y, int width, int height)
     if (data.paused) {
         return 0;
     }
+    flush_sprite_batch();
     SDL_Texture *former_target = SDL_GetRenderTarget(data.renderer);
     if (!former_target) {
         return 0;
@@ -776,6 +870,7 @@ static int save_to_texture(int texture_id, int x, int y, int width, int height)
 
     if (!texture_info || (texture_info && (texture_info->tex_width < width || texture_info->tex_height < height))) {
         if (texture_info) {
+            forget_batched_texture(texture_info->texture);
             SDL_DestroyTexture(texture_info->texture);
             texture_info->texture = 0;
             texture_info->tex_width = 0;
@@ -807,6 +902,7 @@ static int save_to_texture(int texture_id, int x, int y, int width, int height)
         texture_info = malloc(sizeof(buffer_texture));
 
         if (!texture_info) {
+            forget_batched_texture(texture);
             SDL_DestroyTexture(texture);
             return 0;
         }
@@ -845,6 +941,7 @@ static void draw_saved_texture(int texture_id, int x, int y)
     if (!texture_info) {
         return;
     }
+    flush_sprite_batch();
     SDL_Rect src_coords = { 0, 0, texture_info->width, texture_info->height };
     SDL_Rect dst_coords = { x, y, texture_info->width, texture_info->height };
     SDL_RenderCopy(data.renderer, texture_info->texture, &src_coords, &dst_coords);
@@ -852,6 +949,7 @@ static void draw_saved_texture(int texture_id, int x, int y)
 
 static void create_blend_texture(custom_image_type type)
 {
+    flush_sprite_batch();
     SDL_Texture *texture = SDL_CreateTexture(data.renderer, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_TARGET, 58, 30);
     if (!texture) {
         return;
@@ -945,6 +1043,7 @@ static void load_unpacked_image(const image *img, const color_t *pixels)
     data.unpacked_images[index].id = unpacked_image_id;
 
     if (data.unpacked_images[index].texture) {
+        forget_batched_texture(data.unpacked_images[index].texture);
         SDL_DestroyTexture(data.unpacked_images[index].texture);
         data.unpacked_images[index].texture = 0;
     }
@@ -963,6 +1062,7 @@ static void load_unpacked_image(const image *img, const color_t *pixels)
             SDL_FreeSurface(surface);
             return;
         }
+        forget_batched_texture(data.unpacked_images[oldest_texture_index].texture);
         SDL_DestroyTexture(data.unpacked_images[oldest_texture_index].texture);
         data.unpacked_images[oldest_texture_index].texture = 0;
         data.unpacked_images[index].texture = SDL_CreateTextureFromSurface(data.renderer, surface);
@@ -1069,6 +1169,7 @@ int platform_renderer_init(SDL_Window *window)
 
 static void destroy_render_texture(void)
 {
+    flush_sprite_batch();
     if (data.render_texture) {
         SDL_DestroyTexture(data.render_texture);
         data.render_texture = 0;
@@ -1141,11 +1242,13 @@ int platform_renderer_lost_render_texture(void)
 void platform_renderer_invalidate_target_textures(void)
 {
     if (data.custom_textures[CUSTOM_IMAGE_RED_FOOTPRINT].texture) {
+        forget_batched_texture(data.custom_textures[CUSTOM_IMAGE_RED_FOOTPRINT].texture);
         SDL_DestroyTexture(data.custom_textures[CUSTOM_IMAGE_RED_FOOTPRINT].texture);
         data.custom_textures[CUSTOM_IMAGE_RED_FOOTPRINT].texture = 0;
         create_blend_texture(CUSTOM_IMAGE_RED_FOOTPRINT);
     }
     if (data.custom_textures[CUSTOM_IMAGE_GREEN_FOOTPRINT].texture) {
+        forget_batched_texture(data.custom_textures[CUSTOM_IMAGE_GREEN_FOOTPRINT].texture);
         SDL_DestroyTexture(data.custom_textures[CUSTOM_IMAGE_GREEN_FOOTPRINT].texture);
         data.custom_textures[CUSTOM_IMAGE_GREEN_FOOTPRINT].texture = 0;
         create_blend_texture(CUSTOM_IMAGE_GREEN_FOOTPRINT);
@@ -1180,6 +1283,7 @@ void platform_renderer_render(void)
     if (data.paused) {
         return;
     }
+    flush_sprite_batch();
     SDL_SetRenderTarget(data.renderer, NULL);
     SDL_RenderCopy(data.renderer, data.render_texture, NULL, NULL);
 #ifdef PLATFORM_USE_SOFTWARE_CURSOR
@@ -1214,6 +1318,7 @@ void platform_renderer_generate_mouse_cursor_texture(int cursor_id, int size, co
 
 void platform_renderer_pause(void)
 {
+    flush_sprite_batch();
     SDL_SetRenderTarget(data.renderer, NULL);
     data.paused = 1;
 }
@@ -0,0 +1,59 @@
+#include "core/thread.h"
+
+#include "core/log.h"
+
+#include "SDL.h"
+
+#include <stdlib.h>
+
+struct thread {
+    SDL_Thread *sdl_thread;
+    SDL_atomic_t finished;
+    int (*function)(void *data);
+    void *data;
+};
+
+static int run_thread(void *data)
+{
+    thread *t = data;
+    int result = t->function(t->data);
+    SDL_AtomicSet(&t->finished, 1);
+    return result;
+}
+
+thread *thread_create(int (*function)(void *data), void *data)
+{
+    thread *t = malloc(sizeof(thread));
+    if (!t) {
+        return 0;
+    }
+    t->function = function;
+    t->data = data;
+    SDL_AtomicSet(&t->finished, 0);
+    t->sdl_thread = SDL_CreateThread(run_thread, "worker", t);
+    if (!t->sdl_thread) {
+        log_error("Unable to create thread", SDL_GetError(), 0);
+        free(t);
+        return 0;
+    }
+    return t;
+}
+
+int thread_is_finished(thread *t)
+{
+    return SDL_AtomicGet(&t->finished);
+}
+
+int thread_wait(thread *t)
+{
+    int result = 0;
+    SDL_WaitThread(t->sdl_thread, &result);
+    free(t);
+    return result;
+}
+
+int thread_get_core_count(void)
+{
+    int count = SDL_GetCPUCount();
+    return count > 0 ? count : 1;
+}
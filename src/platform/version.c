@@ -0,0 +1,11 @@
+// DO NOT EDIT. This file is generated by CMake.
+// Run CMake configure step to update it.
+#include "game/system.h"
+
+#define JULIUS_VERSION "3.1.0"
+#define JULIUS_VERSION_SUFFIX "-20261016-b817ad3-dirty"
+
+const char *system_version(void)
+{
+    return JULIUS_VERSION JULIUS_VERSION_SUFFIX;
+}
@@ -251,12 +251,12 @@ void sound_city_decay_views(void)
     }
 }
 
-void sound_city_progress_ambient(void)
+void sound_city_progress_ambient(int views)
 {
     for (int i = 0; i < ambient_channels_number; i++) {
         channels[ambient_channels[i]].available = 1;
-        ++channels[ambient_channels[i]].total_views;
-        ++channels[ambient_channels[i]].direction_views[SOUND_DIRECTION_CENTER];
+        channels[ambient_channels[i]].total_views += views;
+        channels[ambient_channels[i]].direction_views[SOUND_DIRECTION_CENTER] += views;
     }
 }
 
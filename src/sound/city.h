@@ -20,7 +20,7 @@ void sound_city_mark_construction_site_view(int direction);
 
 void sound_city_decay_views(void);
 
-void sound_city_progress_ambient(void);
+void sound_city_progress_ambient(int views);
 
 void sound_city_play(void);
 
@@ -767,7 +767,10 @@ static translation_string all_strings[] = {
     {TR_HOTKEY_ROTATE_MAP_NORTH, "Rotate map to North" },
     {TR_HOTKEY_BUILD_WHEAT_FARM, "Wheat farm" },
     {TR_HOTKEY_SHOW_MESSAGES, "Show messages"},   
-    {TR_HOTKEY_SHOW_EMPIRE_MAP, "Show empire map"}     
+    {TR_HOTKEY_SHOW_EMPIRE_MAP, "Show empire map"},
+    {TR_CONFIG_HIERARCHICAL_ROUTING, "Faster routing for invaders and long distance walkers"},
+    {TR_CONFIG_INCREMENTAL_DESIRABILITY, "Only update desirability around changed buildings"},
+    {TR_CONFIG_FAST_AUTOSAVES, "Faster autosaves with slightly larger files"},
 };
 
 void translation_english(const translation_string **strings, int *num_strings)
@@ -762,6 +762,9 @@ typedef enum {
     TR_HOTKEY_BUILD_WHEAT_FARM,
     TR_HOTKEY_SHOW_MESSAGES,
     TR_HOTKEY_SHOW_EMPIRE_MAP,
+    TR_CONFIG_HIERARCHICAL_ROUTING,
+    TR_CONFIG_INCREMENTAL_DESIRABILITY,
+    TR_CONFIG_FAST_AUTOSAVES,
     TRANSLATION_MAX_KEY,
 } translation_key;
 
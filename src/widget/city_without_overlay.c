@@ -28,6 +28,7 @@
 #include "graphics/image.h"
 #include "graphics/window.h"
 #include "map/building.h"
+#include "map/dirty.h"
 #include "map/figure.h"
 #include "map/grid.h"
 #include "map/image.h"
@@ -39,10 +40,22 @@
 #include "widget/city_building_ghost.h"
 #include "widget/city_figure.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 #define OFFSET(x,y) (x + GRID_SIZE * y)
 
 #define WAREHOUSE_FLAG_FRAMES 9
 
+#define DRAW_LIST_SIZE_STEP 4096
+#define DRAW_LIST_ROWS_STEP 128
+
+enum {
+    TILE_DRAW = 1,
+    TILE_GARDEN = 2,
+    TILE_ANIMATION = 4
+};
+
 static const int ADJACENT_OFFSETS[2][4][7] = {
     {
         {OFFSET(-1, 0), OFFSET(-1, -1),  OFFSET(-1, -2), OFFSET(0, -2), OFFSET(1, -2)},
@@ -71,6 +84,42 @@ static struct {
     float scale;
 } draw_context;
 
+typedef struct {
+    int grid_offset;
+    int x;
+    int y;
+    int image_id;
+    int building_id;
+    color_t footprint_color_mask;
+    color_t top_color_mask;
+    int flags;
+} tile_draw_command;
+
+static struct {
+    tile_draw_command *commands;
+    int num_commands;
+    int capacity;
+    int *row_ends;
+    int num_rows;
+    int rows_capacity;
+    int last_row_y;
+    int is_valid;
+    int out_of_memory;
+    struct {
+        int orientation;
+        int scale;
+        int camera_x;
+        int camera_y;
+        int pixel_x;
+        int pixel_y;
+        int x;
+        int y;
+        int width;
+        int height;
+    } view;
+    int command_index[GRID_SIZE * GRID_SIZE];
+} draw_list;
+
 static void init_draw_context(int selected_figure_id, pixel_coordinate *figure_coord, int highlighted_formation)
 {
     draw_context.advance_water_animation = 0;
@@ -114,9 +163,51 @@ static int has_adjacent_deletion(int grid_offset)
     return 0;
 }
 
+static void mark_building_sound(const building *b, int x)
+{
+    if (b->state != BUILDING_STATE_IN_USE) {
+        return;
+    }
+    int view_x, view_y, view_width, view_height;
+    city_view_get_viewport(&view_x, &view_y, &view_width, &view_height);
+    int direction;
+    if (x < view_x + 100) {
+        direction = SOUND_DIRECTION_LEFT;
+    } else if (x > view_x + view_width - 100) {
+        direction = SOUND_DIRECTION_RIGHT;
+    } else {
+        direction = SOUND_DIRECTION_CENTER;
+    }
+    if (building_monument_is_unfinished_monument(b)) {
+        sound_city_mark_construction_site_view(direction);
+    } else {
+        sound_city_mark_building_view(b->type, b->num_workers, direction);
+    }
+}
+
+static void draw_footprint_image(int x, int y, int grid_offset, int *tile_image_id, color_t color_mask)
+{
+    int image_id = *tile_image_id;
+    if (map_property_is_constructing(grid_offset)) { //&&
+      //  !building_is_connectable(building_construction_type())) {
+        image_id = image_group(GROUP_TERRAIN_OVERLAY);
+    }
+    if (draw_context.advance_water_animation &&
+        image_id >= draw_context.image_id_water_first &&
+        image_id <= draw_context.image_id_water_last) {
+        image_id++;
+        if (image_id > draw_context.image_id_water_last) {
+            image_id = draw_context.image_id_water_first;
+        }
+        map_image_set_animation_frame(grid_offset, image_id);
+        *tile_image_id = image_id;
+    }
+    image_draw_isometric_footprint_from_draw_tile(image_id, x, y, color_mask, draw_context.scale);
+}
+
 static void draw_footprint(int x, int y, int grid_offset)
 {
-    sound_city_progress_ambient();
+    sound_city_progress_ambient(1);
     building_construction_record_view_position(x, y, grid_offset);
     if (grid_offset >= 0 && map_property_is_draw_tile(grid_offset)) {
         // Valid grid_offset and leftmost tile -> draw
@@ -127,43 +218,13 @@ static void draw_footprint(int x, int y, int grid_offset)
             if (draw_building_as_deleted(b)) {
                 color_mask = COLOR_MASK_RED;
             }
-            int view_x, view_y, view_width, view_height;
-            city_view_get_viewport(&view_x, &view_y, &view_width, &view_height);
-            
-            if (b->state == BUILDING_STATE_IN_USE) {
-                int direction;
-                if (x < view_x + 100) {
-                    direction = SOUND_DIRECTION_LEFT;
-                } else if (x > view_x + view_width - 100) {
-                    direction = SOUND_DIRECTION_RIGHT;
-                } else {
-                    direction = SOUND_DIRECTION_CENTER;
-                }
-                if (building_monument_is_unfinished_monument(b)) {
-                    sound_city_mark_construction_site_view(direction);
-                } else {
-                    sound_city_mark_building_view(b->type, b->num_workers, direction);
-                }
-            }
+            mark_building_sound(b, x);
         }
         if (map_terrain_is(grid_offset, TERRAIN_GARDEN)) {
             sound_city_mark_building_view(BUILDING_GARDENS, 0, SOUND_DIRECTION_CENTER);
         }
         int image_id = map_image_at(grid_offset);
-        if (map_property_is_constructing(grid_offset)) { //&&
-          //  !building_is_connectable(building_construction_type())) {
-            image_id = image_group(GROUP_TERRAIN_OVERLAY);
-        }
-        if (draw_context.advance_water_animation &&
-            image_id >= draw_context.image_id_water_first &&
-            image_id <= draw_context.image_id_water_last) {
-            image_id++;
-            if (image_id > draw_context.image_id_water_last) {
-                image_id = draw_context.image_id_water_first;
-            }
-            map_image_set(grid_offset, image_id);
-        }
-        image_draw_isometric_footprint_from_draw_tile(image_id, x, y, color_mask, draw_context.scale);
+        draw_footprint_image(x, y, grid_offset, &image_id, color_mask);
     }
 }
 
@@ -308,17 +369,16 @@ static void draw_senate_rating_flags(const building *b, int x, int y, color_t co
     }
 }
 
-static void draw_top(int x, int y, int grid_offset)
+static color_t top_color_mask(building *b, int grid_offset)
 {
-    if (!map_property_is_draw_tile(grid_offset)) {
-        return;
-    }
-    building *b = building_get(map_building_at(grid_offset));
-    int image_id = map_image_at(grid_offset);
-    color_t color_mask = 0;
     if (draw_building_as_deleted(b) || (map_property_is_deleted(grid_offset) && !is_multi_tile_terrain(grid_offset))) {
-        color_mask = COLOR_MASK_RED;
+        return COLOR_MASK_RED;
     }
+    return 0;
+}
+
+static void draw_top_image(int x, int y, building *b, int image_id, color_t color_mask)
+{
     image_draw_isometric_top_from_draw_tile(image_id, x, y, color_mask, draw_context.scale);
     // specific buildings
     draw_senate_rating_flags(b, x, y, color_mask);
@@ -326,6 +386,15 @@ static void draw_top(int x, int y, int grid_offset)
     draw_workshop_raw_material_storage(b, x, y, color_mask);
 }
 
+static void draw_top(int x, int y, int grid_offset)
+{
+    if (!map_property_is_draw_tile(grid_offset)) {
+        return;
+    }
+    building *b = building_get(map_building_at(grid_offset));
+    draw_top_image(x, y, b, map_image_at(grid_offset), top_color_mask(b, grid_offset));
+}
+
 static void draw_figures(int x, int y, int grid_offset)
 {
     int figure_id = map_figure_at(grid_offset);
@@ -664,6 +733,216 @@ static void draw_connectable_construction_ghost(int x, int y, int grid_offset)
     image_draw_isometric_top_from_draw_tile(image_id, x, y, COLOR_MASK_BUILDING_GHOST, draw_context.scale);
 }
 
+static int has_animation(int grid_offset, int image_id, int building_id)
+{
+    if (image_get(image_id)->animation.num_sprites || map_sprite_bridge_at(grid_offset)) {
+        return 1;
+    }
+    building_type type = building_get(building_id)->type;
+    return type == BUILDING_FORT || type == BUILDING_GATEHOUSE;
+}
+
+static void update_command(tile_draw_command *command)
+{
+    int grid_offset = command->grid_offset;
+    command->image_id = map_image_at(grid_offset);
+    command->building_id = map_building_at(grid_offset);
+    command->footprint_color_mask = 0;
+    command->top_color_mask = 0;
+    command->flags = 0;
+    building *b = building_get(command->building_id);
+    if (map_property_is_draw_tile(grid_offset)) {
+        command->flags |= TILE_DRAW;
+        if (draw_building_as_deleted(b)) {
+            command->footprint_color_mask = COLOR_MASK_RED;
+        }
+        command->top_color_mask = top_color_mask(b, grid_offset);
+        if (map_terrain_is(grid_offset, TERRAIN_GARDEN)) {
+            command->flags |= TILE_GARDEN;
+        }
+    }
+    if (has_animation(grid_offset, command->image_id, command->building_id)) {
+        command->flags |= TILE_ANIMATION;
+    }
+}
+
+static int reserve_commands(void)
+{
+    if (draw_list.num_commands >= draw_list.capacity) {
+        int capacity = draw_list.capacity + DRAW_LIST_SIZE_STEP;
+        tile_draw_command *commands = realloc(draw_list.commands, sizeof(tile_draw_command) * capacity);
+        if (!commands) {
+            return 0;
+        }
+        draw_list.commands = commands;
+        draw_list.capacity = capacity;
+    }
+    if (draw_list.num_rows >= draw_list.rows_capacity) {
+        int rows_capacity = draw_list.rows_capacity + DRAW_LIST_ROWS_STEP;
+        int *row_ends = realloc(draw_list.row_ends, sizeof(int) * rows_capacity);
+        if (!row_ends) {
+            return 0;
+        }
+        draw_list.row_ends = row_ends;
+        draw_list.rows_capacity = rows_capacity;
+    }
+    return 1;
+}
+
+static void add_command(int x, int y, int grid_offset)
+{
+    if (draw_list.out_of_memory || !reserve_commands()) {
+        draw_list.out_of_memory = 1;
+        return;
+    }
+    if (!draw_list.num_rows || y != draw_list.last_row_y) {
+        draw_list.num_rows++;
+        draw_list.last_row_y = y;
+    }
+    tile_draw_command *command = &draw_list.commands[draw_list.num_commands];
+    command->grid_offset = grid_offset;
+    command->x = x;
+    command->y = y;
+    update_command(command);
+    draw_list.command_index[grid_offset] = draw_list.num_commands;
+    draw_list.num_commands++;
+    draw_list.row_ends[draw_list.num_rows - 1] = draw_list.num_commands;
+}
+
+static void update_changed_commands(int x_min, int y_min, int x_max, int y_max)
+{
+    for (int y = y_min; y <= y_max; y++) {
+        for (int x = x_min; x <= x_max; x++) {
+            int index = draw_list.command_index[y * GRID_SIZE + x];
+            if (index >= 0) {
+                update_command(&draw_list.commands[index]);
+            }
+        }
+    }
+}
+
+static int view_changed(void)
+{
+    int orientation = city_view_orientation();
+    int scale = city_view_get_scale();
+    int camera_x, camera_y, pixel_x, pixel_y, x, y, width, height;
+    city_view_get_camera(&camera_x, &camera_y);
+    city_view_get_pixel_offset(&pixel_x, &pixel_y);
+    city_view_get_viewport(&x, &y, &width, &height);
+    if (orientation == draw_list.view.orientation && scale == draw_list.view.scale &&
+        camera_x == draw_list.view.camera_x && camera_y == draw_list.view.camera_y &&
+        pixel_x == draw_list.view.pixel_x && pixel_y == draw_list.view.pixel_y &&
+        x == draw_list.view.x && y == draw_list.view.y &&
+        width == draw_list.view.width && height == draw_list.view.height) {
+        return 0;
+    }
+    draw_list.view.orientation = orientation;
+    draw_list.view.scale = scale;
+    draw_list.view.camera_x = camera_x;
+    draw_list.view.camera_y = camera_y;
+    draw_list.view.pixel_x = pixel_x;
+    draw_list.view.pixel_y = pixel_y;
+    draw_list.view.x = x;
+    draw_list.view.y = y;
+    draw_list.view.width = width;
+    draw_list.view.height = height;
+    return 1;
+}
+
+static void build_draw_list(void)
+{
+    map_dirty_clear(MAP_DIRTY_VIEW_CITY);
+    memset(draw_list.command_index, 0xff, sizeof(draw_list.command_index));
+    draw_list.num_commands = 0;
+    draw_list.num_rows = 0;
+    draw_list.out_of_memory = 0;
+    city_view_foreach_valid_map_tile(add_command, 0, 0);
+    draw_list.is_valid = !draw_list.out_of_memory;
+}
+
+static int prepare_draw_list(void)
+{
+    if (view_changed() || !draw_list.is_valid ||
+        !map_dirty_take_changes(MAP_DIRTY_VIEW_CITY, update_changed_commands)) {
+        build_draw_list();
+    }
+    return draw_list.is_valid;
+}
+
+static void draw_cached_footprints(void)
+{
+    sound_city_progress_ambient(draw_list.num_commands);
+    int start_offset = building_construction_get_start_grid_offset();
+    if (start_offset >= 0 && start_offset < GRID_SIZE * GRID_SIZE && draw_list.command_index[start_offset] >= 0) {
+        const tile_draw_command *command = &draw_list.commands[draw_list.command_index[start_offset]];
+        building_construction_record_view_position(command->x, command->y, start_offset);
+    }
+    for (int i = 0; i < draw_list.num_commands; i++) {
+        tile_draw_command *command = &draw_list.commands[i];
+        if (!(command->flags & TILE_DRAW)) {
+            continue;
+        }
+        if (command->building_id) {
+            mark_building_sound(building_get(command->building_id), command->x);
+        }
+        if (command->flags & TILE_GARDEN) {
+            sound_city_mark_building_view(BUILDING_GARDENS, 0, SOUND_DIRECTION_CENTER);
+        }
+        int image_id = command->image_id;
+        draw_footprint_image(command->x, command->y, command->grid_offset,
+            &command->image_id, command->footprint_color_mask);
+        if (command->image_id != image_id) {
+            // water animation frame advanced
+            update_command(command);
+        }
+    }
+}
+
+static void draw_cached_tops_figures_animations(void)
+{
+    int row_start = 0;
+    for (int row = 0; row < draw_list.num_rows; row++) {
+        int row_end = draw_list.row_ends[row];
+        for (int i = row_start; i < row_end; i++) {
+            const tile_draw_command *command = &draw_list.commands[i];
+            if (command->flags & TILE_DRAW) {
+                draw_top_image(command->x, command->y, building_get(command->building_id),
+                    command->image_id, command->top_color_mask);
+            }
+        }
+        for (int i = row_start; i < row_end; i++) {
+            const tile_draw_command *command = &draw_list.commands[i];
+            draw_figures(command->x, command->y, command->grid_offset);
+        }
+        for (int i = row_start; i < row_end; i++) {
+            const tile_draw_command *command = &draw_list.commands[i];
+            if (command->flags & TILE_ANIMATION) {
+                draw_animation(command->x, command->y, command->grid_offset);
+            }
+        }
+        row_start = row_end;
+    }
+}
+
+static void draw_cached_elevated_figures_ornaments(void)
+{
+    int row_start = 0;
+    for (int row = 0; row < draw_list.num_rows; row++) {
+        int row_end = draw_list.row_ends[row];
+        for (int i = row_start; i < row_end; i++) {
+            const tile_draw_command *command = &draw_list.commands[i];
+            draw_elevated_figures(command->x, command->y, command->grid_offset);
+        }
+        for (int i = row_start; i < row_end; i++) {
+            const tile_draw_command *command = &draw_list.commands[i];
+            if (command->flags & TILE_ANIMATION) {
+                draw_hippodrome_ornaments(command->x, command->y, command->grid_offset);
+            }
+        }
+        row_start = row_end;
+    }
+}
+
 void city_without_overlay_draw(int selected_figure_id, pixel_coordinate *figure_coord, const map_tile *tile)
 {
     int highlighted_formation = 0;
@@ -684,24 +963,39 @@ void city_without_overlay_draw(int selected_figure_id, pixel_coordinate *figure_
     city_view_get_viewport(&x, &y, &width, &height);
     graphics_fill_rect(x, y, width, height, COLOR_BLACK);
     int should_mark_deleting = city_building_ghost_mark_deleting(tile);
-    city_view_foreach_valid_map_tile(draw_footprint, 0, 0);
+    // tiles marked for deletion are not tracked as map changes, so the draw list is not used while deleting
+    int use_draw_list = !should_mark_deleting && prepare_draw_list();
+    if (use_draw_list) {
+        draw_cached_footprints();
+    } else {
+        draw_list.is_valid = 0;
+        city_view_foreach_valid_map_tile(draw_footprint, 0, 0);
+    }
     if (!should_mark_deleting) {
-        city_view_foreach_valid_map_tile(
-            draw_top,
-            draw_figures,
-            draw_animation
-        );
+        if (use_draw_list) {
+            draw_cached_tops_figures_animations();
+        } else {
+            city_view_foreach_valid_map_tile(
+                draw_top,
+                draw_figures,
+                draw_animation
+            );
+        }
         if (!selected_figure_id) {
             if (building_is_connectable(building_construction_type())) {
                 city_view_foreach_map_tile(draw_connectable_construction_ghost);
             }
             city_building_ghost_draw(tile);
         }
-        city_view_foreach_valid_map_tile(
-            draw_elevated_figures,
-            draw_hippodrome_ornaments,
-            0
-        );
+        if (use_draw_list) {
+            draw_cached_elevated_figures_ornaments();
+        } else {
+            city_view_foreach_valid_map_tile(
+                draw_elevated_figures,
+                draw_hippodrome_ornaments,
+                0
+            );
+        }
     } else {
         city_view_foreach_map_tile(deletion_draw_terrain_top);
         city_view_foreach_map_tile(deletion_draw_figures_animations);
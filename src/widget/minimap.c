@@ -11,6 +11,7 @@
 #include "graphics/renderer.h"
 #include "map/building.h"
 #include "map/figure.h"
+#include "map/dirty.h"
 #include "map/grid.h"
 #include "map/property.h"
 #include "map/random.h"
@@ -18,6 +19,11 @@
 #include "scenario/property.h"
 
 #include <stdlib.h>
+#include <string.h>
+
+// The largest buildings are 7 tiles wide, so a building drawn on one row reaches 6 rows above and below it
+#define MAX_BUILDING_ROW_REACH 6
+#define NO_POSITION -32768
 
 enum {
     FIGURE_COLOR_NONE = 0,
@@ -30,7 +36,8 @@ enum {
 enum {
     REFRESH_NOT_NEEDED = 0,
     REFRESH_FULL = 1,
-    REFRESH_CAMERA_MOVED = 2
+    REFRESH_CAMERA_MOVED = 2,
+    REFRESH_CHANGES = 3
 };
 
 static const color_t ENEMY_COLOR_BY_CLIMATE[] = {
@@ -135,12 +142,25 @@ static struct {
     color_t enemy_color;
     color_t *cache;
     int cache_width;
+    struct {
+        color_t *pixels;
+        uint8_t *changed_rows;
+        int width;
+        int height;
+        int y_min;
+        int y_max;
+    } terrain;
+    struct {
+        short x;
+        short y;
+    } tile_positions[GRID_SIZE * GRID_SIZE];
     struct {
         int x;
         int y;
         int grid_offset;
     } mouse;
     int refresh_requested;
+    int update_requested;
     int camera_x;
     int camera_y;
 } data;
@@ -150,6 +170,11 @@ void widget_minimap_invalidate(void)
     data.refresh_requested = 1;
 }
 
+void widget_minimap_update(void)
+{
+    data.update_requested = 1;
+}
+
 static void foreach_map_tile(map_callback *callback)
 {
     city_view_foreach_minimap_tile(data.x_offset, data.y_offset,
@@ -212,6 +237,14 @@ static int has_figure_color(figure *f)
 }
 
 static inline void draw_pixel(int x, int y, color_t color)
+{
+    if (x < 0 || x >= data.width || y < data.terrain.y_min || y >= data.terrain.y_max) {
+        return;
+    }
+    data.terrain.pixels[y * data.width + x] = color;
+}
+
+static inline void draw_figure_pixel(int x, int y, color_t color)
 {
     if (x < 0 || x >= data.width || y < 0 || y >= data.height) {
         return;
@@ -219,11 +252,11 @@ static inline void draw_pixel(int x, int y, color_t color)
     data.cache[y * data.cache_width + x] = color;
 }
 
-static int draw_figure(int x_view, int y_view, int grid_offset)
+static void draw_figure(int x_view, int y_view, int grid_offset)
 {
     int color_type = map_figure_foreach_until(grid_offset, has_figure_color);
     if (color_type == FIGURE_COLOR_NONE) {
-        return 0;
+        return;
     }
     color_t color = COLOR_MINIMAP_WOLF;
     if (color_type == FIGURE_COLOR_SOLDIER) {
@@ -233,9 +266,8 @@ static int draw_figure(int x_view, int y_view, int grid_offset)
     } else if (color_type == FIGURE_COLOR_ENEMY) {
         color = data.enemy_color;
     }
-    draw_pixel(x_view, y_view, color);
-    draw_pixel(x_view + 1, y_view, color);
-    return 1;
+    draw_figure_pixel(x_view, y_view, color);
+    draw_figure_pixel(x_view + 1, y_view, color);
 }
 
 static inline void draw_tile(int x_offset, int y_offset, const tile_color *colors)
@@ -253,10 +285,10 @@ static void draw_building(int size, int x_offset, int y_offset, const tile_color
     int width = size * 2;
     int height = width - 1;
     y_offset -= size - 1;
-    int start_y = y_offset < 0 ? -y_offset : 0;
+    int start_y = y_offset < data.terrain.y_min ? data.terrain.y_min - y_offset : 0;
     int end_y = height / 2 + 1;
-    if (end_y + y_offset > data.height) {
-        end_y = data.height - y_offset;
+    if (end_y + y_offset > data.terrain.y_max) {
+        end_y = data.terrain.y_max - y_offset;
     }
     for (int y = start_y; y < end_y; y++) {
         int x_start = height / 2 - y;
@@ -269,16 +301,16 @@ static void draw_building(int size, int x_offset, int y_offset, const tile_color
         if (x_end + x_offset >= data.width) {
             x_end = data.width - x_offset;
         }
-        color_t *value = &data.cache[(y_offset + y) * data.cache_width + x_start + x_offset + 1];
+        color_t *value = &data.terrain.pixels[(y_offset + y) * data.width + x_start + x_offset + 1];
         for (int x = x_start; x < x_end - 1; x++) {
             *value++ = ((x + y) & 1) ? colors[0].left : colors[0].right;
         }
     }
     y_offset += height / 2 + 1;
-    start_y = y_offset < 0 ? -y_offset : 0;
+    start_y = y_offset < data.terrain.y_min ? data.terrain.y_min - y_offset : 0;
     end_y = height / 2;
-    if (end_y + y_offset > data.height) {
-        end_y = data.height - y_offset;
+    if (end_y + y_offset > data.terrain.y_max) {
+        end_y = data.terrain.y_max - y_offset;
     }
 
     for (int y = start_y; y < end_y; y++) {
@@ -292,7 +324,7 @@ static void draw_building(int size, int x_offset, int y_offset, const tile_color
         if (x_end + x_offset >= data.width) {
             x_end = data.width - x_offset;
         }
-        color_t *value = &data.cache[(y_offset + y) * data.cache_width + x_start + x_offset + 1];
+        color_t *value = &data.terrain.pixels[(y_offset + y) * data.width + x_start + x_offset + 1];
         for (int x = x_start; x < x_end - 1; x++) {
             *value++ = ((x + y) & 1) ? colors[0].right : colors[0].left;
         }
@@ -310,10 +342,8 @@ static void draw_minimap_tile(int x_view, int y_view, int grid_offset)
         draw_tile(x_view, y_view, &set->black);
         return;
     }
-
-    if (draw_figure(x_view, y_view, grid_offset)) {
-        return;
-    }
+    data.tile_positions[grid_offset].x = x_view;
+    data.tile_positions[grid_offset].y = y_view;
 
     int terrain = map_terrain_get(grid_offset);
     // exception for fort ground: display as empty land
@@ -386,38 +416,155 @@ static void draw_viewport_rectangle(void)
         COLOR_MINIMAP_VIEWPORT);
 }
 
+static int prepare_terrain_cache(int width, int height)
+{
+    if (data.terrain.pixels && width == data.terrain.width && height == data.terrain.height) {
+        return 1;
+    }
+    free(data.terrain.pixels);
+    free(data.terrain.changed_rows);
+    data.terrain.pixels = malloc(sizeof(color_t) * width * height);
+    data.terrain.changed_rows = malloc(height);
+    if (!data.terrain.pixels || !data.terrain.changed_rows) {
+        free(data.terrain.pixels);
+        free(data.terrain.changed_rows);
+        data.terrain.pixels = 0;
+        data.terrain.changed_rows = 0;
+        return 0;
+    }
+    data.terrain.width = width;
+    data.terrain.height = height;
+    return 1;
+}
+
 static void prepare_minimap_cache(int width, int height)
 {
     if (width != data.width || height != data.height || !graphics_renderer()->has_custom_image(CUSTOM_IMAGE_MINIMAP)) {
         graphics_renderer()->create_custom_image(CUSTOM_IMAGE_MINIMAP, width, height);
     }
     data.cache = graphics_renderer()->get_custom_image_buffer(CUSTOM_IMAGE_MINIMAP, &data.cache_width);
+    if (!prepare_terrain_cache(width, height)) {
+        data.cache = 0;
+    }
 }
 
-static void clear_minimap(void)
+static void draw_terrain_rows(int y_min, int y_max)
 {
-    for (int y = 0; y < data.height; y++) {
-        color_t *line = &data.cache[y * data.cache_width];
-        for (int x = 0; x < data.cache_width; x++) {
+    for (int y = y_min; y < y_max; y++) {
+        color_t *line = &data.terrain.pixels[y * data.width];
+        for (int x = 0; x < data.width; x++) {
             line[x] = COLOR_BLACK;
         }
     }
+    data.terrain.y_min = y_min;
+    data.terrain.y_max = y_max;
+
+    // Draw the same tiles, in the same order, as a full draw would to reach these rows.
+    // A full draw goes through the rows from 4 above the minimap to 4 below it.
+    int first_row = (y_min - MAX_BUILDING_ROW_REACH) & ~1;
+    if (first_row < -4) {
+        first_row = -4;
+    }
+    int last_row = y_max + MAX_BUILDING_ROW_REACH;
+    if (last_row > data.height + 4) {
+        last_row = data.height + 4;
+    }
+    int start = first_row + 4;
+    city_view_foreach_minimap_tile(data.x_offset, data.y_offset + start,
+        data.absolute_x, data.absolute_y + start,
+        data.width_tiles, last_row - first_row - 8,
+        draw_minimap_tile);
 }
 
-static void draw_minimap(void)
+static void draw_all_terrain(void)
 {
-    if (!data.cache) {
+    for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        data.tile_positions[i].y = NO_POSITION;
+    }
+    // everything is drawn now, so earlier map changes are no longer needed
+    map_dirty_clear(MAP_DIRTY_VIEW_MINIMAP);
+    draw_terrain_rows(0, data.height);
+}
+
+static void mark_changed_rows(int x_min, int y_min, int x_max, int y_max)
+{
+    for (int y = y_min; y <= y_max; y++) {
+        for (int x = x_min; x <= x_max; x++) {
+            int row = data.tile_positions[x + GRID_SIZE * y].y;
+            if (row == NO_POSITION) {
+                continue;
+            }
+            int first = row - MAX_BUILDING_ROW_REACH;
+            int last = row + MAX_BUILDING_ROW_REACH;
+            for (int r = first < 0 ? 0 : first; r <= last && r < data.height; r++) {
+                data.terrain.changed_rows[r] = 1;
+            }
+        }
+    }
+}
+
+static void draw_changed_terrain(void)
+{
+    memset(data.terrain.changed_rows, 0, data.height);
+    if (!map_dirty_take_changes(MAP_DIRTY_VIEW_MINIMAP, mark_changed_rows)) {
+        draw_all_terrain();
         return;
     }
+    int y = 0;
+    while (y < data.height) {
+        if (!data.terrain.changed_rows[y]) {
+            y++;
+            continue;
+        }
+        int y_min = y;
+        while (y < data.height && data.terrain.changed_rows[y]) {
+            y++;
+        }
+        draw_terrain_rows(y_min, y);
+    }
+}
+
+static void draw_figures(void)
+{
+    for (int i = figure_next_in_use(0); i; i = figure_next_in_use(i)) {
+        figure *f = figure_get(i);
+        if (!map_grid_is_valid_offset(f->grid_offset) || has_figure_color(f) == FIGURE_COLOR_NONE) {
+            continue;
+        }
+        int y = data.tile_positions[f->grid_offset].y;
+        if (y != NO_POSITION) {
+            draw_figure(data.tile_positions[f->grid_offset].x, y, f->grid_offset);
+        }
+    }
+}
+
+static void draw_cached_image(void)
+{
     graphics_set_clip_rectangle(data.x_offset, data.y_offset, data.width, data.height);
-    clear_minimap();
-    foreach_map_tile(draw_minimap_tile);
-    graphics_renderer()->update_custom_image(CUSTOM_IMAGE_MINIMAP);
     graphics_renderer()->draw_custom_image(CUSTOM_IMAGE_MINIMAP, data.x_offset, data.y_offset, SCALE_NONE);
     draw_viewport_rectangle();
     graphics_reset_clip_rectangle();
 }
 
+static void compose_and_draw(void)
+{
+    for (int y = 0; y < data.height; y++) {
+        memcpy(&data.cache[y * data.cache_width], &data.terrain.pixels[y * data.width], sizeof(color_t) * data.width);
+    }
+    draw_figures();
+    graphics_renderer()->update_custom_image(CUSTOM_IMAGE_MINIMAP);
+    draw_cached_image();
+}
+
+static void draw_minimap(void)
+{
+    if (!data.cache) {
+        return;
+    }
+    draw_all_terrain();
+    compose_and_draw();
+}
+
 static void draw_uncached(int x_offset, int y_offset, int width, int height)
 {
     data.enemy_color = ENEMY_COLOR_BY_CLIMATE[scenario_property_climate()];
@@ -426,9 +573,10 @@ static void draw_uncached(int x_offset, int y_offset, int width, int height)
     draw_minimap();
 }
 
-static void draw_using_cache(int x_offset, int y_offset, int width, int height)
+static void draw_using_cache(int x_offset, int y_offset, int width, int height, int update_changes)
 {
-    if (width != data.width || height != data.height || x_offset != data.x_offset) {
+    if (width != data.width || height != data.height || x_offset != data.x_offset ||
+        !data.cache || !graphics_renderer()->has_custom_image(CUSTOM_IMAGE_MINIMAP)) {
         draw_uncached(x_offset, y_offset, width, height);
         return;
     }
@@ -440,19 +588,25 @@ static void draw_using_cache(int x_offset, int y_offset, int width, int height)
         draw_minimap();
         return;
     }
-
-    graphics_set_clip_rectangle(x_offset, y_offset, width, height);
-    graphics_renderer()->draw_custom_image(CUSTOM_IMAGE_MINIMAP, data.x_offset, data.y_offset, SCALE_NONE);
-    draw_viewport_rectangle();
-    graphics_reset_clip_rectangle();
+    if (update_changes) {
+        draw_changed_terrain();
+        compose_and_draw();
+        return;
+    }
+    draw_cached_image();
 }
 
 static int should_refresh(int force)
 {
     if (data.refresh_requested || force) {
         data.refresh_requested = 0;
+        data.update_requested = 0;
         return REFRESH_FULL;
     }
+    if (data.update_requested) {
+        data.update_requested = 0;
+        return REFRESH_CHANGES;
+    }
     int new_x, new_y;
     city_view_get_camera(&new_x, &new_y);
     if (data.camera_x != new_x || data.camera_y != new_y) {
@@ -468,7 +622,7 @@ void widget_minimap_draw(int x_offset, int y_offset, int width, int height, int
         if (refresh_type == REFRESH_FULL) {
             draw_uncached(x_offset, y_offset, width, height);
         } else {
-            draw_using_cache(x_offset, y_offset, width, height);
+            draw_using_cache(x_offset, y_offset, width, height, refresh_type == REFRESH_CHANGES);
         }
         graphics_draw_line(x_offset - 1, x_offset - 1 + width, y_offset - 1, y_offset - 1, COLOR_MINIMAP_DARK);
         graphics_draw_line(x_offset - 1, x_offset - 1, y_offset, y_offset + height, COLOR_MINIMAP_DARK);
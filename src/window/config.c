@@ -210,6 +210,7 @@ static config_widget all_widgets[CONFIG_PAGES][MAX_WIDGETS] = {
         {TYPE_CHECKBOX, CONFIG_UI_INVERSE_MAP_DRAG, TR_CONFIG_UI_INVERSE_MAP_DRAG},
         {TYPE_CHECKBOX, CONFIG_UI_MESSAGE_ALERTS, TR_CONFIG_UI_MESSAGE_ALERTS},
         {TYPE_CHECKBOX, CONFIG_UI_SHOW_GRID_DURING_CONSTRUCTION, TR_CONFIG_UI_SHOW_GRID_DURING_CONSTRUCTION},
+        {TYPE_CHECKBOX, CONFIG_GENERAL_FAST_AUTOSAVES, TR_CONFIG_FAST_AUTOSAVES},
     },
     { // Difficulty
         {TYPE_NUMERICAL_DESC, RANGE_DIFFICULTY, TR_CONFIG_DIFFICULTY},
@@ -239,6 +240,8 @@ static config_widget all_widgets[CONFIG_PAGES][MAX_WIDGETS] = {
         {TYPE_CHECKBOX, CONFIG_GP_CH_WAREHOUSES_DONT_ACCEPT, TR_CONFIG_NOT_ACCEPTING_WAREHOUSES },
         {TYPE_CHECKBOX, CONFIG_GP_CH_HOUSES_DONT_EXPAND_INTO_GARDENS, TR_CONFIG_HOUSES_DONT_EXPAND_INTO_GARDENS },
         {TYPE_CHECKBOX, CONFIG_GP_CH_ROAMERS_DONT_SKIP_CORNERS, TR_CONFIG_ROAMERS_DONT_SKIP_CORNERS },
+        {TYPE_CHECKBOX, CONFIG_GP_CH_HIERARCHICAL_ROUTING, TR_CONFIG_HIERARCHICAL_ROUTING },
+        {TYPE_CHECKBOX, CONFIG_GP_CH_INCREMENTAL_DESIRABILITY, TR_CONFIG_INCREMENTAL_DESIRABILITY },
     }
 };
 
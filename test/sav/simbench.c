@@ -0,0 +1,245 @@
+#include "core/time.h"
+#include "game/file.h"
+#include "game/game.h"
+#include "game/settings.h"
+#include "game/tick.h"
+#include "game/time.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_TICKS 5000
+#define MAX_SAVES 16
+#define TICK_SLOTS 50
+
+static const char *DEFAULT_SAVES[] = {
+    "brugle-massilia-start.sav",
+    "brugle-lugdunum.sav",
+    "brugle-palacepeaks.sav",
+    "inv0.sav"
+};
+
+#define NUM_DEFAULT_SAVES ((int) (sizeof(DEFAULT_SAVES) / sizeof(DEFAULT_SAVES[0])))
+
+typedef struct {
+    int count;
+    double total_ms;
+    double max_ms;
+} slot_stats;
+
+typedef struct {
+    const char *name;
+    int ticks;
+    double total_ms;
+    double min_ms;
+    double median_ms;
+    double p99_ms;
+    double max_ms;
+    slot_stats slots[TICK_SLOTS];
+} save_result;
+
+static struct {
+    int ticks;
+    const char *json_file;
+    const char *saves[MAX_SAVES];
+    int num_saves;
+    save_result results[MAX_SAVES];
+    double *tick_ms;
+} data;
+
+static void handler(int sig)
+{
+    fprintf(stderr, "Oops, crashed with signal %d :(", sig);
+    exit(1);
+}
+
+static double current_time_ms(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart * 1000.0 / frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+#endif
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double da = *(const double *) a;
+    double db = *(const double *) b;
+    return da < db ? -1 : (da > db ? 1 : 0);
+}
+
+static double percentile(const double *sorted, int count, int percent)
+{
+    int index = (count - 1) * percent / 100;
+    return sorted[index];
+}
+
+static int run_save(const char *saved_game, save_result *result)
+{
+    printf("Benchmarking %s over %d ticks\n", saved_game, data.ticks);
+    if (!game_file_load_saved_game(saved_game)) {
+        printf("Unable to load saved game %s\n", saved_game);
+        return 0;
+    }
+    memset(result, 0, sizeof(save_result));
+    result->name = saved_game;
+    result->ticks = data.ticks;
+
+    setting_reset_speeds(500, setting_scroll_speed());
+    time_set_millis(0);
+    for (int i = 0; i < data.ticks; i++) {
+        // the tick slot is advanced at the end of the tick, so read it before running
+        int slot = game_time_tick();
+        time_set_millis(2 * (i + 1));
+        double start = current_time_ms();
+        game_tick_run();
+        double elapsed = current_time_ms() - start;
+
+        data.tick_ms[i] = elapsed;
+        result->total_ms += elapsed;
+        if (slot >= 0 && slot < TICK_SLOTS) {
+            slot_stats *stats = &result->slots[slot];
+            stats->count++;
+            stats->total_ms += elapsed;
+            if (elapsed > stats->max_ms) {
+                stats->max_ms = elapsed;
+            }
+        }
+    }
+    qsort(data.tick_ms, data.ticks, sizeof(double), compare_doubles);
+    result->min_ms = data.tick_ms[0];
+    result->median_ms = percentile(data.tick_ms, data.ticks, 50);
+    result->p99_ms = percentile(data.tick_ms, data.ticks, 99);
+    result->max_ms = data.tick_ms[data.ticks - 1];
+    return 1;
+}
+
+static double ticks_per_second(const save_result *result)
+{
+    return result->total_ms > 0 ? result->ticks * 1000.0 / result->total_ms : 0;
+}
+
+static void print_result(const save_result *result)
+{
+    printf("%s: %.0f ticks/s, tick min %.3f ms, median %.3f ms, p99 %.3f ms, max %.3f ms\n",
+        result->name, ticks_per_second(result),
+        result->min_ms, result->median_ms, result->p99_ms, result->max_ms);
+    printf("  slot  count    mean ms     max ms\n");
+    for (int slot = 0; slot < TICK_SLOTS; slot++) {
+        const slot_stats *stats = &result->slots[slot];
+        if (stats->count) {
+            printf("  %4d %6d %10.4f %10.4f\n", slot, stats->count, stats->total_ms / stats->count, stats->max_ms);
+        }
+    }
+}
+
+static void write_json(FILE *fp)
+{
+    fprintf(fp, "{\n  \"ticks\": %d,\n  \"saves\": [\n", data.ticks);
+    for (int i = 0; i < data.num_saves; i++) {
+        const save_result *result = &data.results[i];
+        fprintf(fp, "    {\n");
+        fprintf(fp, "      \"name\": \"%s\",\n", result->name);
+        fprintf(fp, "      \"ticks_per_second\": %.2f,\n", ticks_per_second(result));
+        fprintf(fp, "      \"total_ms\": %.3f,\n", result->total_ms);
+        fprintf(fp, "      \"tick_ms\": { \"min\": %.4f, \"median\": %.4f, \"p99\": %.4f, \"max\": %.4f },\n",
+            result->min_ms, result->median_ms, result->p99_ms, result->max_ms);
+        fprintf(fp, "      \"slots\": [\n");
+        int first = 1;
+        for (int slot = 0; slot < TICK_SLOTS; slot++) {
+            const slot_stats *stats = &result->slots[slot];
+            if (!stats->count) {
+                continue;
+            }
+            fprintf(fp, "%s        { \"slot\": %d, \"count\": %d, \"mean_ms\": %.4f, \"max_ms\": %.4f }",
+                first ? "" : ",\n", slot, stats->count, stats->total_ms / stats->count, stats->max_ms);
+            first = 0;
+        }
+        fprintf(fp, "\n      ]\n    }%s\n", i < data.num_saves - 1 ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+}
+
+static int parse_arguments(int argc, char **argv)
+{
+    data.ticks = DEFAULT_TICKS;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            data.ticks = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            data.json_file = argv[++i];
+        } else if (argv[i][0] == '-') {
+            return 0;
+        } else if (data.num_saves < MAX_SAVES) {
+            data.saves[data.num_saves++] = argv[i];
+        }
+    }
+    if (!data.num_saves) {
+        for (int i = 0; i < NUM_DEFAULT_SAVES; i++) {
+            data.saves[data.num_saves++] = DEFAULT_SAVES[i];
+        }
+    }
+    return data.ticks > 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (!parse_arguments(argc, argv)) {
+        printf("Usage: simbench [--ticks N] [--json output.json] [saved games...]\n");
+        return -1;
+    }
+    signal(SIGSEGV, handler);
+
+    if (!game_pre_init()) {
+        printf("Unable to run Game_preInit\n");
+        return 1;
+    }
+    if (!game_init()) {
+        printf("Unable to run Game_init\n");
+        return 2;
+    }
+    data.tick_ms = malloc(sizeof(double) * data.ticks);
+    if (!data.tick_ms) {
+        printf("Unable to allocate memory for %d ticks\n", data.ticks);
+        return 1;
+    }
+    for (int i = 0; i < data.num_saves; i++) {
+        if (!run_save(data.saves[i], &data.results[i])) {
+            free(data.tick_ms);
+            return 3;
+        }
+        print_result(&data.results[i]);
+    }
+    free(data.tick_ms);
+
+    if (data.json_file) {
+        FILE *fp = fopen(data.json_file, "w");
+        if (!fp) {
+            printf("Unable to write %s\n", data.json_file);
+            return 4;
+        }
+        write_json(fp);
+        fclose(fp);
+    } else {
+        write_json(stdout);
+    }
+
+    game_exit();
+
+    return 0;
+}
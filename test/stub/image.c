@@ -62,3 +62,11 @@ const image *image_get(int id)
 {
     return 0;
 }
+
+int image_load_external_pixels(color_t *dst, int image_id, int row_width)
+{
+    return 0;
+}
+
+void image_crop(image *img, const color_t *pixels, int reduce_width)
+{}
@@ -0,0 +1,58 @@
+#include "graphics/renderer.h"
+
+static graphics_renderer_interface renderer;
+
+static void get_max_image_size(int *width, int *height)
+{
+    *width = 0;
+    *height = 0;
+}
+
+static const image_atlas_data *prepare_image_atlas(atlas_type type, int num_images, int last_width, int last_height)
+{
+    return 0;
+}
+
+static int create_image_atlas(const image_atlas_data *data)
+{
+    return 0;
+}
+
+static int has_image_atlas(atlas_type type)
+{
+    return 0;
+}
+
+static void free_image_atlas(atlas_type type)
+{}
+
+static void load_unpacked_image(const image *img, const color_t *pixels)
+{}
+
+static int should_pack_image(int width, int height)
+{
+    return 0;
+}
+
+static int isometric_images_are_joined(void)
+{
+    return 0;
+}
+
+static void update_scale_mode(int city_scale)
+{}
+
+const graphics_renderer_interface *graphics_renderer(void)
+{
+    // nothing is drawn: only the calls made while loading assets and changing the city view are needed
+    renderer.get_max_image_size = get_max_image_size;
+    renderer.prepare_image_atlas = prepare_image_atlas;
+    renderer.create_image_atlas = create_image_atlas;
+    renderer.has_image_atlas = has_image_atlas;
+    renderer.free_image_atlas = free_image_atlas;
+    renderer.load_unpacked_image = load_unpacked_image;
+    renderer.should_pack_image = should_pack_image;
+    renderer.isometric_images_are_joined = isometric_images_are_joined;
+    renderer.update_scale_mode = update_scale_mode;
+    return &renderer;
+}
@@ -0,0 +1,21 @@
+#include "core/thread.h"
+
+thread *thread_create(int (*function)(void *data), void *data)
+{
+    return 0;
+}
+
+int thread_is_finished(thread *t)
+{
+    return 1;
+}
+
+int thread_wait(thread *t)
+{
+    return 0;
+}
+
+int thread_get_core_count(void)
+{
+    return 1;
+}
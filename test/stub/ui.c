@@ -55,12 +55,19 @@ void window_message_dialog_show_city_message(int text_id, int year, int month,
                                              int param1, int param2, int message_advisor, int use_popup)
 {}
 
-void window_popup_dialog_show(popup_dialog_type type, void (*okFunc)(int), int hasOkCancelButtons)
+void window_popup_dialog_show(popup_dialog_type type, void (*okFunc)(int, int), int hasOkCancelButtons)
+{}
+
+void window_popup_dialog_show_confirmation(const uint8_t *custom_title, const uint8_t *custom_text,
+    const uint8_t *checkbox_text, void (*close_func)(int accepted, int checked))
 {}
 
 void widget_minimap_invalidate(void)
 {}
 
+void widget_minimap_update(void)
+{}
+
 int window_building_info_get_building_type(void)
 {
     return 0;